@@ -0,0 +1,210 @@
+#include "AdaptiveHuffmanTree.h"
+
+#include <algorithm>
+
+/* Конструктор */
+AdaptiveHuffmanTree::AdaptiveHuffmanTree()
+{
+    Reset();
+}
+
+/* Начальное состояние: дерево из одного узла NYT */
+void AdaptiveHuffmanTree::Reset()
+{
+    m_nodes.clear();
+    m_nodes.reserve(2 * 256 + 1);
+    m_nodes.push_back({ NoNode, NoNode, NoNode, 0, NoNode });
+
+    std::fill(std::begin(m_leaves), std::end(m_leaves), NoNode);
+    m_nyt = 0;
+
+    m_currentNode = 0;
+    m_pendingBits = SymbolBits;
+    m_pendingSymbol = 0;
+    m_failed = false;
+}
+
+/* Кодирование отдельного символа, текста */
+void AdaptiveHuffmanTree::Encode(char symbol, std::string& encodedText)
+{
+    int index = static_cast<unsigned char>(symbol);
+
+    if (m_leaves[index] != NoNode)
+    {
+        AppendCode(m_leaves[index], encodedText);
+    }
+    else
+    {
+        /* Новый символ: код NYT и сам символ в открытом виде */
+        AppendCode(m_nyt, encodedText);
+
+        for (int bit = SymbolBits - 1; bit >= 0; bit--)
+        {
+            encodedText += ((index >> bit) & 1) ? '1' : '0';
+        }
+    }
+
+    Update(index);
+}
+
+std::string AdaptiveHuffmanTree::Encode(const std::string& text)
+{
+    std::string encodedText = "";
+
+    for (char huffmanChar : text)
+    {
+        Encode(huffmanChar, encodedText);
+    }
+
+    return encodedText;
+}
+
+void AdaptiveHuffmanTree::AppendCode(int node, std::string& encodedText) const
+{
+    size_t start = encodedText.size();
+
+    while (m_nodes[node].m_parent != NoNode)
+    {
+        int parent = m_nodes[node].m_parent;
+        encodedText += (m_nodes[parent].m_left == node) ? '0' : '1';
+        node = parent;
+    }
+
+    std::reverse(encodedText.begin() + start, encodedText.end());
+}
+
+/* Декодирование текста. Состояние сохраняется между вызовами, поэтому поток
+   можно подавать порциями, разрезанными в произвольном месте */
+HuffmanTree::DecodeStatus AdaptiveHuffmanTree::Decode(const std::string& text, std::string& decodedText)
+{
+    if (m_failed)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    for (char huffmanChar : text)
+    {
+        if (huffmanChar != '0' && huffmanChar != '1')
+        {
+            m_failed = true;
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        int bit = huffmanChar - '0';
+
+        if (m_pendingBits > 0)
+        {
+            m_pendingSymbol = (m_pendingSymbol << 1) | bit;
+
+            if (--m_pendingBits == 0)
+            {
+                decodedText += static_cast<char>(m_pendingSymbol);
+                Update(m_pendingSymbol);
+                m_pendingSymbol = 0;
+                EnterNode(0, decodedText);
+            }
+
+            continue;
+        }
+
+        EnterNode(bit ? m_nodes[m_currentNode].m_right : m_nodes[m_currentNode].m_left, decodedText);
+    }
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+std::string AdaptiveHuffmanTree::Decode(const std::string& text)
+{
+    std::string decodedText = "";
+    Decode(text, decodedText);
+
+    return decodedText;
+}
+
+void AdaptiveHuffmanTree::EnterNode(int node, std::string& decodedText)
+{
+    m_currentNode = node;
+
+    if (node == m_nyt)
+    {
+        m_pendingBits = SymbolBits;
+    }
+    else if (m_nodes[node].m_left == NoNode)
+    {
+        int symbol = m_nodes[node].m_symbol;
+        decodedText += static_cast<char>(symbol);
+        Update(symbol);
+        m_currentNode = 0;
+    }
+}
+
+/* Обновление дерева: увеличиваем веса от листа к корню, предварительно
+   переставляя узел на место лидера его блока, чтобы сохранить свойство соседства */
+void AdaptiveHuffmanTree::Update(int symbol)
+{
+    int node = m_leaves[symbol];
+
+    if (node == NoNode)
+    {
+        /* NYT становится внутренним узлом: слева новый NYT, справа лист символа */
+        int oldNyt = m_nyt;
+        int leaf = static_cast<int>(m_nodes.size());
+        int newNyt = leaf + 1;
+
+        m_nodes.push_back({ oldNyt, NoNode, NoNode, 0, symbol });
+        m_nodes.push_back({ oldNyt, NoNode, NoNode, 0, NoNode });
+
+        m_nodes[oldNyt].m_left = newNyt;
+        m_nodes[oldNyt].m_right = leaf;
+
+        m_leaves[symbol] = leaf;
+        m_nyt = newNyt;
+        node = leaf;
+    }
+
+    while (node != NoNode)
+    {
+        int leader = node;
+        uint64_t weight = m_nodes[node].m_weight;
+
+        while (leader > 0 && m_nodes[leader - 1].m_weight == weight)
+        {
+            leader--;
+        }
+
+        if (leader != node && leader != m_nodes[node].m_parent)
+        {
+            SwapNodes(node, leader);
+            node = leader;
+        }
+
+        m_nodes[node].m_weight++;
+        node = m_nodes[node].m_parent;
+    }
+}
+
+void AdaptiveHuffmanTree::SwapNodes(int first, int second)
+{
+    std::swap(m_nodes[first], m_nodes[second]);
+    std::swap(m_nodes[first].m_parent, m_nodes[second].m_parent);
+
+    for (int node : { first, second })
+    {
+        Node& current = m_nodes[node];
+
+        if (current.m_left != NoNode)
+        {
+            m_nodes[current.m_left].m_parent = node;
+            m_nodes[current.m_right].m_parent = node;
+        }
+        else if (current.m_symbol != NoNode)
+        {
+            m_leaves[current.m_symbol] = node;
+        }
+        else
+        {
+            m_nyt = node;
+        }
+    }
+}
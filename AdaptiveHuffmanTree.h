@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "HuffmanTree.h"
+
+/* Адаптивное дерево Хаффмана (алгоритм FGK).
+   Дерево перестраивается после каждого символа, поэтому кодирование не требует
+   предварительного подсчёта частот и заголовка: первый бит выдаётся сразу после
+   первого символа. Кодер и декодер - два независимых экземпляра, которые проходят
+   одинаковую последовательность обновлений.
+   Знак порции, отличный от '0' и '1', - неверный код: Decode возвращает
+   InvalidCode, и декодер до Reset остаётся в состоянии ошибки. */
+class AdaptiveHuffmanTree
+{
+public:
+    AdaptiveHuffmanTree();                                                                              // Конструктор
+
+    void Reset();                                                                                       // Возврат в начальное состояние
+
+    void Encode(char symbol, std::string& encodedText);                                                 // Кодирование отдельного символа (дописывает биты)
+
+    std::string Encode(const std::string& text);                                                        // Кодирование текста
+
+    HuffmanTree::DecodeStatus Decode(const std::string& text, std::string& decodedText);                // Декодирование очередной порции битов
+
+    std::string Decode(const std::string& text);                                                        // Декодирование текста (при ошибке - символы до неё)
+
+private:
+    /* Узлы хранятся в порядке убывания номеров FGK: индекс 0 - корень */
+    struct Node
+    {
+        int m_parent;
+        int m_left;
+        int m_right;
+        uint64_t m_weight;                                                                              // У корня - число переданных символов
+        int m_symbol;
+    };
+
+    enum { NoNode = -1, SymbolBits = 8 };
+
+    std::vector<Node> m_nodes;
+    int m_leaves[256];                                                                                  // Лист каждого символа или NoNode
+    int m_nyt;                                                                                          // Узел "ещё не передан" (NYT)
+
+    int m_currentNode;                                                                                  // Состояние декодера между порциями
+    int m_pendingBits;
+    int m_pendingSymbol;
+    bool m_failed;                                                                                      // Во входе был знак не '0' и не '1'
+
+    void Update(int symbol);                                                                            // Обновление дерева после символа
+
+    void SwapNodes(int first, int second);                                                              // Обмен поддеревьев местами
+
+    void AppendCode(int node, std::string& encodedText) const;                                          // Код узла от корня
+
+    void EnterNode(int node, std::string& decodedText);                                                 // Переход декодера в узел
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* Запись и чтение битов через 64-битный накопитель.
+   Биты идут от старшего к младшему: первый бит кода - старший бит первого байта.
+   Поток дополняется нулями до целого байта; точная длина в битах хранится
+   отдельно (BitWriter::BitCount), поэтому дополнение никогда не декодируется.
+   Методы определены в заголовке, чтобы встраиваться в циклы кодера и декодера. */
+
+/* Класс "Запись битов" */
+class BitWriter
+{
+public:
+    static const int MaxWriteBits = 56;                                                                 // Наибольшая длина одной записи
+
+    explicit BitWriter(size_t expectedBytes = 0)                                                        // Конструктор
+    {
+        m_buffer.resize(expectedBytes + sizeof(uint64_t));
+    }
+
+    /* Запись count младших битов значения bits (0 <= count <= 56, старшие биты bits нулевые).
+       Накопитель целиком сбрасывается в буфер невыровненной 8-байтовой записью,
+       указатель сдвигается на число полных байтов - без ветвления по битам */
+    void WriteBits(uint64_t bits, int count)
+    {
+        if (m_position + sizeof(uint64_t) > m_buffer.size())
+        {
+            m_buffer.resize(m_buffer.size() * 2);
+        }
+
+        m_container |= (bits << 1 << (63 - count)) >> m_bitCount;
+        m_bitCount += count;
+
+        uint64_t bigEndian = __builtin_bswap64(m_container);
+        std::memcpy(m_buffer.data() + m_position, &bigEndian, sizeof(bigEndian));
+
+        int bytes = m_bitCount >> 3;
+        m_position += bytes;
+        m_container <<= bytes * 8;
+        m_bitCount &= 7;
+    }
+
+    size_t BitCount() const                                                                             // Записано битов (без дополнения)
+    {
+        return m_position * 8 + m_bitCount;
+    }
+
+    /* Завершение потока: неполный последний байт дополняется нулями
+       (он уже лежит в буфере после последней записи) */
+    std::vector<uint8_t> Finish()
+    {
+        m_buffer.resize(m_position + (m_bitCount + 7) / 8);
+
+        return std::move(m_buffer);
+    }
+
+private:
+    std::vector<uint8_t> m_buffer;
+    size_t m_position = 0;                                                                              // Первый незавершённый байт
+    uint64_t m_container = 0;                                                                           // Незаписанные биты, выровнены влево
+    int m_bitCount = 0;
+};
+
+/* Класс "Чтение битов" */
+class BitReader
+{
+public:
+    static const int MaxPeekBits = 56;                                                                  // Гарантировано после Refill
+
+    BitReader(const uint8_t* data, size_t size)                                                         // Конструктор
+        : m_data(data), m_size(size)
+    {
+        Refill();
+    }
+
+    /* Дозаполнение накопителя до 56..63 битов. Читается сразу 8 байт без учёта
+       того, сколько битов осталось; за концом данных читаются нули */
+    void Refill()
+    {
+        uint64_t next;
+
+        if (m_position + sizeof(uint64_t) <= m_size)
+        {
+            std::memcpy(&next, m_data + m_position, sizeof(next));
+        }
+        else
+        {
+            next = 0;
+
+            if (m_position < m_size)
+            {
+                std::memcpy(&next, m_data + m_position, m_size - m_position);
+            }
+        }
+
+        m_container |= __builtin_bswap64(next) >> m_bitCount;
+        m_position += (63 - m_bitCount) >> 3;
+        m_bitCount |= 56;
+    }
+
+    uint64_t PeekBits(int count) const                                                                  // Следующие count битов (0 <= count <= 56)
+    {
+        return (m_container >> 1) >> (63 - count);
+    }
+
+    void ConsumeBits(int count)
+    {
+        m_container <<= count;
+        m_bitCount -= count;
+    }
+
+    uint64_t ReadBits(int count)
+    {
+        uint64_t bits = PeekBits(count);
+        ConsumeBits(count);
+
+        return bits;
+    }
+
+    int BitsAvailable() const                                                                           // Битов в накопителе
+    {
+        return m_bitCount;
+    }
+
+    size_t BitPosition() const                                                                          // Прочитано битов с начала
+    {
+        return m_position * 8 - m_bitCount;
+    }
+
+    bool IsOverrun() const                                                                              // Прочитаны нули за концом данных
+    {
+        return BitPosition() > m_size * 8;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_position = 0;                                                                              // Следующий байт для загрузки
+    uint64_t m_container = 0;                                                                           // Непрочитанные биты, выровнены влево
+    int m_bitCount = 0;
+};
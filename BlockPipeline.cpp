@@ -0,0 +1,229 @@
+#include "BlockPipeline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "HuffmanBlock.h"
+
+/* Конструктор */
+BlockPipeline::BlockPipeline(size_t blockSize, unsigned workerCount, bool checksum)
+    : m_blockSize(std::max<size_t>(blockSize, 1)), m_workerCount(workerCount), m_checksum(checksum)
+{
+    if (m_workerCount == 0)
+    {
+        m_workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_maxBlocksInFlight = 2 * static_cast<size_t>(m_workerCount) + 2;
+}
+
+/* Сжатие: каждый блок входа кодируется в кадр (длина и блок) */
+bool BlockPipeline::Compress(std::istream& input, std::ostream& output) const
+{
+    Reader read = [&](std::string& buffer, bool& finished)
+        {
+            buffer.resize(m_blockSize);
+            input.read(&buffer[0], static_cast<std::streamsize>(m_blockSize));
+            buffer.resize(static_cast<size_t>(input.gcount()));
+            finished = buffer.empty();
+
+            return !input.bad();
+        };
+
+    Transform encode = [&](const std::string& text, std::string& frame)
+        {
+            std::vector<uint8_t> block = HuffmanBlock::Encode(text, CompressibilityEstimator(), m_checksum).first;
+            std::vector<uint8_t> length;
+            HuffmanBlock::WriteVarint(block.size(), length);
+
+            frame.assign(length.begin(), length.end());
+            frame.append(block.begin(), block.end());
+
+            return true;
+        };
+
+    return Run(read, encode, output);
+}
+
+/* Распаковка: кадры декодируются независимо, повреждённый блок
+   останавливает конвейер */
+bool BlockPipeline::Decompress(std::istream& input, std::ostream& output) const
+{
+    Reader read = [&](std::string& frame, bool& finished)
+        {
+            return ReadFrame(input, frame, finished);
+        };
+
+    Transform decode = [](const std::string& frame, std::string& text)
+        {
+            return HuffmanBlock::Decode(std::vector<uint8_t>(frame.begin(), frame.end()), text);
+        };
+
+    return Run(read, decode, output);
+}
+
+/* Общая часть конвейера. Задания нумеруются при чтении; писатель ждёт
+   результат со следующим номером, а читатель - пока число блоков в работе
+   не станет меньше m_maxBlocksInFlight. Блоки по мегабайту, поэтому одного
+   мьютекса на всё состояние достаточно */
+bool BlockPipeline::Run(const Reader& read, const Transform& transform, std::ostream& output) const
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<size_t, std::string>> pending;
+    std::map<size_t, std::string> completed;
+    size_t readCount = 0;
+    size_t writtenCount = 0;
+    bool readFinished = false;
+    bool failed = false;
+
+    std::thread reader([&]()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return failed || readCount - writtenCount < m_maxBlocksInFlight; });
+
+                    if (failed)
+                    {
+                        return;
+                    }
+                }
+
+                std::string buffer;
+                bool finished = false;
+                bool success = read(buffer, finished);
+
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (!success || finished)
+                {
+                    failed |= !success;
+                    readFinished = true;
+                    changed.notify_all();
+
+                    return;
+                }
+
+                pending.emplace_back(readCount++, std::move(buffer));
+                changed.notify_all();
+            }
+        });
+
+    std::vector<std::thread> workers;
+
+    for (unsigned worker = 0; worker < m_workerCount; worker++)
+    {
+        workers.emplace_back([&]()
+            {
+                while (true)
+                {
+                    std::pair<size_t, std::string> job;
+
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&]() { return failed || readFinished || !pending.empty(); });
+
+                        if (failed || pending.empty())
+                        {
+                            return;
+                        }
+
+                        job = std::move(pending.front());
+                        pending.pop_front();
+                    }
+
+                    std::string result;
+                    bool success = transform(job.second, result);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failed |= !success;
+                    completed.emplace(job.first, std::move(result));
+                    changed.notify_all();
+                }
+            });
+    }
+
+    /* Писатель - текущий поток */
+    while (true)
+    {
+        std::string result;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return failed || completed.count(writtenCount) || (readFinished && writtenCount == readCount); });
+
+            if (failed || !completed.count(writtenCount))
+            {
+                break;
+            }
+
+            result = std::move(completed[writtenCount]);
+            completed.erase(writtenCount);
+        }
+
+        output.write(result.data(), static_cast<std::streamsize>(result.size()));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        failed |= !output;
+        writtenCount++;
+        changed.notify_all();
+    }
+
+    reader.join();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return !failed;
+}
+
+/* Кадр: varint длины и блок. Конец потока перед кадром - нормальное
+   завершение, внутри кадра - ошибка */
+bool BlockPipeline::ReadFrame(std::istream& input, std::string& frame, bool& finished)
+{
+    uint64_t length = 0;
+    finished = false;
+
+    for (int shift = 0; ; shift += 7)
+    {
+        int byte = input.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            finished = (shift == 0);
+
+            return finished && !input.bad();
+        }
+
+        if (shift >= 64)
+        {
+            return false;
+        }
+
+        length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            break;
+        }
+    }
+
+    if (length > MaxFrameBytes)
+    {
+        return false;
+    }
+
+    frame.resize(static_cast<size_t>(length));
+    input.read(&frame[0], static_cast<std::streamsize>(length));
+
+    return static_cast<uint64_t>(input.gcount()) == length;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/* Конвейер сжатия потока блоками.
+   Поток-читатель заполняет буферы по blockSize байт, рабочие потоки
+   независимо кодируют их в HuffmanBlock, поток-писатель выводит готовые
+   блоки в исходном порядке. Чтение, кодирование и запись идут одновременно,
+   поэтому время работы близко к большему из времени ввода-вывода и счёта,
+   а не к их сумме. Число блоков в работе ограничено, так что память
+   не зависит от размера входа.
+
+   Сжатый поток - последовательность кадров: varint длины блока и сам блок.
+   Распаковка устроена так же: читатель выделяет кадры, рабочие декодируют
+   блоки, писатель выводит текст по порядку. */
+class BlockPipeline
+{
+public:
+    static const size_t MaxFrameBytes = size_t(1) << 30;                                                // Кадр больше считается повреждённым
+
+    explicit BlockPipeline(size_t blockSize = 1 << 20, unsigned workerCount = 0, bool checksum = true); // Конструктор (0 потоков - по числу ядер)
+
+    bool Compress(std::istream& input, std::ostream& output) const;                                     // Сжатие потока (false - ошибка ввода-вывода)
+
+    bool Decompress(std::istream& input, std::ostream& output) const;                                   // Распаковка (false - повреждённые данные)
+
+private:
+    size_t m_blockSize;
+    unsigned m_workerCount;
+    size_t m_maxBlocksInFlight;                                                                         // Прочитанные, но ещё не записанные блоки
+    bool m_checksum;                                                                                    // Блоки с CRC32C
+
+    using Reader = std::function<bool(std::string& buffer, bool& finished)>;
+    using Transform = std::function<bool(const std::string& input, std::string& output)>;
+
+    bool Run(const Reader& read, const Transform& transform, std::ostream& output) const;               // Читатель, рабочие и писатель
+
+    static bool ReadFrame(std::istream& input, std::string& frame, bool& finished);                     // Очередной кадр сжатого потока
+};
@@ -0,0 +1,80 @@
+#include "CompressibilityEstimator.h"
+
+#include <algorithm>
+
+#include "HuffmanBlock.h"
+#include "HuffmanKernels.h"
+
+/* Конструктор */
+CompressibilityEstimator::CompressibilityEstimator(double minSavings)
+    : m_minSavings(minSavings)
+{
+}
+
+CompressionMetrics CompressibilityEstimator::Estimate(const std::string& text) const
+{
+    bool exact = false;
+
+    return HuffmanBlock::EstimateMetrics(SampleFrequencies(text, exact));
+}
+
+bool CompressibilityEstimator::IsWorthCompressing(const std::string& text) const
+{
+    return IsWorthCompressing(Estimate(text));
+}
+
+/* Экономия считается относительно хранимого блока того же размера */
+bool CompressibilityEstimator::IsWorthCompressing(const CompressionMetrics& metrics) const
+{
+    double storedBytes = static_cast<double>(HuffmanBlock::StoredSize(metrics.m_symbolCount));
+
+    return metrics.m_containerBytes <= storedBytes * (1.0 - m_minSavings);
+}
+
+/* Небольшие блоки считаются целиком. В больших берётся каждый SampleStride-й
+   отрезок, а частоты умножаются на долю невыбранных данных, причём символ,
+   попавший в выборку, остаётся ненулевым. exact сообщает, что гистограмма
+   посчитана целиком и совпадает с HuffmanKernels::CountBytes */
+std::vector<uint64_t> CompressibilityEstimator::SampleFrequencies(const std::string& text, bool& exact) const
+{
+    std::vector<uint64_t> frequencies(256, 0);
+    size_t step = SampleSegment * SampleStride;
+    exact = text.size() < step * 4;
+
+    if (exact)
+    {
+        HuffmanKernels::CountBytes(text.data(), text.size(), frequencies.data());
+
+        return frequencies;
+    }
+
+    size_t sampled = 0;
+
+    for (size_t start = 0; start < text.size(); start += step)
+    {
+        size_t end = std::min(start + SampleSegment, text.size());
+
+        for (size_t position = start; position < end; position++)
+        {
+            frequencies[static_cast<unsigned char>(text[position])]++;
+        }
+
+        sampled += end - start;
+    }
+
+    double scale = static_cast<double>(text.size()) / sampled;
+    uint64_t total = 0;
+
+    for (uint64_t& frequency : frequencies)
+    {
+        frequency = static_cast<uint64_t>(frequency * scale);
+        total += frequency;
+    }
+
+    /* Округление вниз теряет часть символов: добавляем их самому частому,
+       чтобы оценка описывала блок ровно из text.size() символов */
+    auto largest = std::max_element(frequencies.begin(), frequencies.end());
+    *largest += text.size() - total;
+
+    return frequencies;
+}
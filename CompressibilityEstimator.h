@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CompressionMetrics.h"
+
+/* Оценка сжимаемости блока.
+   Гистограмма строится по выборке: из каждых SampleStride отрезков по
+   SampleSegment байт читается один, затем частоты масштабируются на весь
+   блок и по ним строится только дерево (HuffmanBlock::EstimateMetrics).
+   Блоки меньше 4 шагов выборки считаются целиком; такую точную гистограмму
+   HuffmanBlock::Encode использует повторно, не считая байты второй раз.
+   Если ожидаемая экономия меньше minSavings, блок сохраняется без сжатия,
+   и на уже сжатых данных не тратится полный проход кодера. */
+class CompressibilityEstimator
+{
+public:
+    static const size_t SampleSegment = 256;
+    static const size_t SampleStride = 16;
+
+    explicit CompressibilityEstimator(double minSavings = 0.02);                                        // Конструктор (доля от хранимого блока)
+
+    CompressionMetrics Estimate(const std::string& text) const;                                         // Оценка показателей по выборке
+
+    bool IsWorthCompressing(const std::string& text) const;                                             // Стоит ли сжимать блок
+
+    bool IsWorthCompressing(const CompressionMetrics& metrics) const;                                   // То же по готовым показателям
+
+    std::vector<uint64_t> SampleFrequencies(const std::string& text, bool& exact) const;                // Гистограмма выборки (exact - посчитан весь блок)
+
+private:
+    double m_minSavings;
+};
@@ -0,0 +1,41 @@
+#include "CompressionMetrics.h"
+
+#include <cmath>
+
+#include "HuffmanBlock.h"
+
+double CompressionMetrics::CompressionRatio() const
+{
+    return (m_containerBytes == 0) ? 0.0 : static_cast<double>(m_symbolCount) / m_containerBytes;
+}
+
+/* Показатели по гистограмме и длинам кодов (0 - символа нет) */
+CompressionMetrics CompressionMetrics::Calculate(const std::vector<uint64_t>& frequencies, const std::vector<int>& codeLengths)
+{
+    CompressionMetrics metrics;
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        metrics.m_symbolCount += frequencies[symbol];
+        metrics.m_payloadBits += frequencies[symbol] * codeLengths[symbol];
+    }
+
+    for (uint64_t frequency : frequencies)
+    {
+        if (frequency > 0)
+        {
+            metrics.m_entropyBits += static_cast<double>(frequency) * std::log2(static_cast<double>(metrics.m_symbolCount) / static_cast<double>(frequency));
+        }
+    }
+
+    if (metrics.m_symbolCount > 0)
+    {
+        metrics.m_redundancy = (metrics.m_payloadBits - metrics.m_entropyBits) / metrics.m_symbolCount;
+    }
+
+    size_t payloadBytes = (metrics.m_payloadBits + 7) / 8;
+    metrics.m_headerBytes = HuffmanBlock::HeaderSize(metrics.m_symbolCount, codeLengths, payloadBytes);
+    metrics.m_containerBytes = metrics.m_headerBytes + payloadBytes;
+
+    return metrics;
+}
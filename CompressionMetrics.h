@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Показатели сжатия блока.
+   Считаются по гистограмме и таблице длин кодов за O(размер алфавита),
+   без кодирования, поэтому их можно получить до того, как решать,
+   стоит ли сжимать блок. */
+struct CompressionMetrics
+{
+    uint64_t m_symbolCount = 0;                                                                         // Входных байтов
+    uint64_t m_payloadBits = 0;                                                                         // Точная длина закодированных данных
+    size_t m_headerBytes = 0;                                                                           // Заголовок блока HuffmanBlock
+    size_t m_containerBytes = 0;                                                                        // Заголовок и данные целиком
+    double m_entropyBits = 0;                                                                           // Граница Шеннона для данных
+    double m_redundancy = 0;                                                                            // Избыточность кода, бит на символ
+
+    double CompressionRatio() const;                                                                    // Входные байты / байты блока
+
+    static CompressionMetrics Calculate(const std::vector<uint64_t>& frequencies, const std::vector<int>& codeLengths);
+};
@@ -0,0 +1,60 @@
+#include "CpuFeatures.h"
+
+#include <cstdlib>
+#include <cstring>
+
+bool CpuFeatures::Supports(Isa isa)
+{
+    return isa <= Best();
+}
+
+CpuFeatures::Isa CpuFeatures::Best()
+{
+    static const Isa best = Detect();
+
+    return best;
+}
+
+const char* CpuFeatures::Name(Isa isa)
+{
+    static const char* const names[IsaCount] = { "scalar", "sse4.2", "avx2", "bmi2" };
+
+    return names[isa];
+}
+
+/* Уровень растёт, пока процессор поддерживает следующий набор */
+CpuFeatures::Isa CpuFeatures::Detect()
+{
+    Isa best = Scalar;
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+    {
+        best = Sse42;
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            best = Avx2;
+
+            if (__builtin_cpu_supports("bmi2"))
+            {
+                best = Bmi2;
+            }
+        }
+    }
+#endif
+
+    const char* limit = std::getenv("HUFFMAN_ISA");
+
+    for (int isa = Scalar; limit && isa < best; isa++)
+    {
+        if (std::strcmp(limit, Name(static_cast<Isa>(isa))) == 0)
+        {
+            best = static_cast<Isa>(isa);
+        }
+    }
+
+    return best;
+}
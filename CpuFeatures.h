@@ -0,0 +1,25 @@
+#pragma once
+
+/* Наборы инструкций процессора для выбора вычислительных ядер.
+   Уровни упорядочены: каждый следующий предполагает предыдущие (Bmi2 -
+   процессоры с AVX2 и BMI2, начиная с Haswell). Определяются один раз
+   через cpuid (__builtin_cpu_supports). Переменная окружения HUFFMAN_ISA
+   (scalar, sse4.2, avx2, bmi2) ограничивает уровень сверху, чтобы
+   проверять запасные реализации на новом процессоре.
+   Уровень Sse42 выбирает только аппаратный CRC32C (Crc32c): у ядер
+   упаковки кодов и декодирования варианта SSE4.2 нет, они различаются
+   на уровнях Scalar, Avx2 и Bmi2. */
+class CpuFeatures
+{
+public:
+    enum Isa { Scalar, Sse42, Avx2, Bmi2, IsaCount };
+
+    static bool Supports(Isa isa);                                                                      // Уровень доступен и не запрещён HUFFMAN_ISA
+
+    static Isa Best();                                                                                  // Наибольший доступный уровень
+
+    static const char* Name(Isa isa);
+
+private:
+    static Isa Detect();                                                                                // Уровень процессора с учётом HUFFMAN_ISA
+};
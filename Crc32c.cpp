@@ -0,0 +1,115 @@
+#include "Crc32c.h"
+
+#include <cstring>
+
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+/* Таблицы slice-by-8: m_tables[0] - обычная побайтовая таблица,
+   m_tables[k] - вклад байта, за которым следуют ещё k нулевых байтов */
+struct Crc32cTables
+{
+    uint32_t m_tables[8][256];
+};
+
+constexpr Crc32cTables BuildCrc32cTables()
+{
+    Crc32cTables tables{};
+
+    for (uint32_t byte = 0; byte < 256; byte++)
+    {
+        uint32_t crc = byte;
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+        }
+
+        tables.m_tables[0][byte] = crc;
+    }
+
+    for (int slice = 1; slice < 8; slice++)
+    {
+        for (int byte = 0; byte < 256; byte++)
+        {
+            uint32_t previous = tables.m_tables[slice - 1][byte];
+            tables.m_tables[slice][byte] = (previous >> 8) ^ tables.m_tables[0][previous & 0xFF];
+        }
+    }
+
+    return tables;
+}
+
+constexpr Crc32cTables crcTables = BuildCrc32cTables();
+
+uint32_t Crc32c::Calculate(const void* data, size_t size, uint32_t crc)
+{
+    return HasHardwareSupport() ? CalculateHardware(data, size, crc) : CalculateSliced(data, size, crc);
+}
+
+bool Crc32c::HasHardwareSupport()
+{
+    return CpuFeatures::Supports(CpuFeatures::Sse42);
+}
+
+/* По 8 байт за шаг: слово читается в порядке little-endian, как и в BitWriter */
+uint32_t Crc32c::CalculateSliced(const void* data, size_t size, uint32_t crc)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint32_t (*tables)[256] = crcTables.m_tables;
+    crc = ~crc;
+
+    while (size >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        word ^= crc;
+
+        crc = tables[7][word & 0xFF] ^ tables[6][(word >> 8) & 0xFF] ^ tables[5][(word >> 16) & 0xFF] ^ tables[4][(word >> 24) & 0xFF] ^
+            tables[3][(word >> 32) & 0xFF] ^ tables[2][(word >> 40) & 0xFF] ^ tables[1][(word >> 48) & 0xFF] ^ tables[0][word >> 56];
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0)
+    {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *bytes++) & 0xFF];
+    }
+
+    return ~crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t Crc32c::CalculateHardware(const void* data, size_t size, uint32_t crc)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t state = ~crc;
+
+    while (size >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0)
+    {
+        state = _mm_crc32_u8(static_cast<uint32_t>(state), *bytes++);
+    }
+
+    return ~static_cast<uint32_t>(state);
+}
+#else
+uint32_t Crc32c::CalculateHardware(const void* data, size_t size, uint32_t crc)
+{
+    return CalculateSliced(data, size, crc);
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* CRC32C (полином Кастаньоли 0x1EDC6F41, отражённая форма 0x82F63B78).
+   На процессорах x86 с SSE4.2 считается инструкцией crc32 по 8 байт,
+   иначе - таблицами slice-by-8, построенными при компиляции. Выбор
+   делается один раз при первом вызове. Значение для "123456789" -
+   0xE3069283. */
+class Crc32c
+{
+public:
+    static uint32_t Calculate(const void* data, size_t size, uint32_t crc = 0);                         // Продолжение crc на следующие байты
+
+    static bool HasHardwareSupport();                                                                   // Доступна инструкция crc32 (SSE4.2)
+
+    static uint32_t CalculateSliced(const void* data, size_t size, uint32_t crc = 0);                   // Табличный вариант
+
+    static uint32_t CalculateHardware(const void* data, size_t size, uint32_t crc = 0);                 // Только при HasHardwareSupport()
+};
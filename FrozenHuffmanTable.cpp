@@ -0,0 +1,43 @@
+#include "FrozenHuffmanTable.h"
+
+#include "BitStream.h"
+#include "HuffmanKernels.h"
+
+/* Конструктор */
+FrozenHuffmanTable::FrozenHuffmanTable(const HuffmanTree& tree)
+    : m_codeTable(tree.BuildPackedCodeTable()), m_decodeTable(tree)
+{
+}
+
+/* Заморозка дерева */
+std::shared_ptr<const FrozenHuffmanTable> FrozenHuffmanTable::Create(const HuffmanTree& tree)
+{
+    return std::shared_ptr<const FrozenHuffmanTable>(new FrozenHuffmanTable(tree));
+}
+
+/* Кодирование текста */
+std::vector<uint8_t> FrozenHuffmanTable::Encode(const std::string& text) const
+{
+    BitWriter writer(text.size() / 2);
+    HuffmanKernels::EncodeBytes(text.data(), text.size(), m_codeTable.data(), m_codeTable.size(), writer);
+
+    return writer.Finish();
+}
+
+/* Декодирование текста */
+std::string FrozenHuffmanTable::Decode(const std::vector<uint8_t>& data, size_t symbolCount) const
+{
+    return m_decodeTable.Decode(data, symbolCount);
+}
+
+/* Декодирование с проверкой: повреждённые данные отличаются от пустого
+   сообщения статусом, как у HuffmanDecodeTable */
+HuffmanTree::DecodeStatus FrozenHuffmanTable::Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const
+{
+    return m_decodeTable.Decode(data, size, symbolCount, decodedText);
+}
+
+const std::vector<HuffmanTree::Code>& FrozenHuffmanTable::GetCodeTable() const
+{
+    return m_codeTable;
+}
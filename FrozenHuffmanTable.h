@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HuffmanTree.h"
+#include "HuffmanDecodeTable.h"
+
+/* Замороженная таблица кодов для общего использования потоками.
+   Строится один раз по дереву (дерево - построитель, его можно удалить
+   или перестроить) и дальше не меняется: кодер и декодер держат состояние
+   в локальных BitWriter/BitReader, поэтому любое число потоков может
+   одновременно работать с одним экземпляром без блокировок и копий.
+   Создаётся только через Create и передаётся как shared_ptr<const ...>. */
+class FrozenHuffmanTable
+{
+public:
+    static std::shared_ptr<const FrozenHuffmanTable> Create(const HuffmanTree& tree);                   // Заморозка дерева
+
+    FrozenHuffmanTable(const FrozenHuffmanTable&) = delete;
+
+    FrozenHuffmanTable& operator=(const FrozenHuffmanTable&) = delete;
+
+    std::vector<uint8_t> Encode(const std::string& text) const;                                         // Кодирование текста
+
+    std::string Decode(const std::vector<uint8_t>& data, size_t symbolCount) const;                     // Декодирование текста (пустая строка при ошибке)
+
+    HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const;
+
+    const std::vector<HuffmanTree::Code>& GetCodeTable() const;                                         // Коды всех символов
+
+private:
+    explicit FrozenHuffmanTable(const HuffmanTree& tree);                                               // Конструктор
+
+    const std::vector<HuffmanTree::Code> m_codeTable;
+    const HuffmanDecodeTable m_decodeTable;
+};
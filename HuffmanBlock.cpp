@@ -0,0 +1,924 @@
+#include "HuffmanBlock.h"
+
+#include <algorithm>
+
+#include "BitStream.h"
+#include "Crc32c.h"
+#include "HuffmanTree.h"
+#include "HuffmanDecodeTable.h"
+#include "HuffmanKernels.h"
+#include "Lz77Coder.h"
+#include "TansCoder.h"
+#include "Utf8Alphabet.h"
+#include "Utf8DecodeTable.h"
+
+/* Кодирование текста в блок. Сначала оценка по выборке; затем, уже по точной
+   гистограмме, ещё одна проверка до упаковки битов. Если сжатие не окупается,
+   получается хранимый блок. По той же гистограмме оценивается блок tANS:
+   он выбирается, если меньше блока Хаффмана больше чем на 1/64 - при
+   почти равных размерах коды Хаффмана декодируются быстрее */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::Encode(const std::string& text)
+{
+    return Encode(text, CompressibilityEstimator());
+}
+
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::Encode(const std::string& text, const CompressibilityEstimator& estimator, bool checksum)
+{
+    bool exact = false;
+    std::vector<uint64_t> frequencies = estimator.SampleFrequencies(text, exact);
+
+    if (!estimator.IsWorthCompressing(EstimateMetrics(frequencies)))
+    {
+        return EncodeStored(text, checksum);
+    }
+
+    /* Небольшой блок оценщик уже посчитал целиком - второй проход не нужен */
+    if (!exact)
+    {
+        frequencies = HuffmanKernels::CountBytes(text);
+    }
+
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(frequencies);
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+    CompressionMetrics metrics = CompressionMetrics::Calculate(frequencies, codeLengths);
+
+    if (!estimator.IsWorthCompressing(metrics))
+    {
+        return EncodeStored(text, checksum);
+    }
+
+    std::vector<int> counts = TansCoder::NormalizeCounts(frequencies, TansCoder::DefaultTableLog);
+
+    if (!counts.empty())
+    {
+        size_t payloadBytes = static_cast<size_t>((TansCoder::EstimateBits(frequencies, counts, TansCoder::DefaultTableLog) + 7) / 8);
+
+        if (TansHeaderSize(text.size(), counts, payloadBytes) + payloadBytes + metrics.m_containerBytes / 64 < metrics.m_containerBytes)
+        {
+            return EncodeTans(text, counts, metrics, checksum);
+        }
+    }
+
+    /* Дерево с каноническими кодами тех же длин - его восстановит декодер */
+    HuffmanTree canonicalTree;
+    canonicalTree.BuildFromCodeLengths(codeLengths);
+    std::vector<HuffmanTree::Code> codeTable = canonicalTree.BuildPackedCodeTable();
+
+    BitWriter writer(static_cast<size_t>(metrics.m_payloadBits / 8));
+    HuffmanKernels::EncodeBytes(text.data(), text.size(), codeTable.data(), codeTable.size(), writer);
+
+    std::vector<uint8_t> payload = writer.Finish();
+    std::vector<uint8_t> block;
+
+    if (checksum)
+    {
+        metrics.m_headerBytes += ChecksumBytes;
+        metrics.m_containerBytes += ChecksumBytes;
+    }
+
+    block.reserve(metrics.m_containerBytes);
+    WriteType(Huffman, text, checksum, block);
+    WriteVarint(text.size(), block);
+    WriteCodeLengths(codeLengths, block);
+    WriteVarint(payload.size(), block);
+    block.insert(block.end(), payload.begin(), payload.end());
+
+    return std::make_pair(block, metrics);
+}
+
+/* Кодирование в чередующиеся потоки: дерево и коды те же, что у Encode,
+   каждый поток упаковывается отдельно из своих символов. Число потоков -
+   8 или 16 (другие значения заменяются на 16): на 8 потоках цикл AVX2
+   ограничен задержкой gather, две группы по 8 идут вдвое быстрее */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeInterleaved(const std::string& text, int laneCount, bool checksum)
+{
+    laneCount = (laneCount == 8) ? 8 : 16;
+
+    std::vector<uint64_t> frequencies = HuffmanKernels::CountBytes(text);
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(frequencies);
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+    CompressionMetrics metrics = CompressionMetrics::Calculate(frequencies, codeLengths);
+
+    if (!CompressibilityEstimator().IsWorthCompressing(metrics))
+    {
+        return EncodeStored(text, checksum);
+    }
+
+    HuffmanTree canonicalTree;
+    canonicalTree.BuildFromCodeLengths(codeLengths);
+    std::vector<HuffmanTree::Code> codeTable = canonicalTree.BuildPackedCodeTable();
+
+    std::vector<std::vector<uint8_t>> payloads(laneCount);
+    std::string laneText;
+    size_t payloadBytes = 0;
+
+    for (int lane = 0; lane < laneCount; lane++)
+    {
+        laneText.clear();
+
+        for (size_t position = lane; position < text.size(); position += laneCount)
+        {
+            laneText.push_back(text[position]);
+        }
+
+        BitWriter writer(static_cast<size_t>(metrics.m_payloadBits / 8 / laneCount));
+        HuffmanKernels::EncodeBytes(laneText.data(), laneText.size(), codeTable.data(), codeTable.size(), writer);
+        payloads[lane] = writer.Finish();
+        payloadBytes += payloads[lane].size();
+    }
+
+    std::vector<uint8_t> block;
+    WriteType(Interleaved, text, checksum, block);
+    WriteVarint(text.size(), block);
+    WriteCodeLengths(codeLengths, block);
+    block.push_back(static_cast<uint8_t>(laneCount));
+
+    for (const std::vector<uint8_t>& payload : payloads)
+    {
+        WriteVarint(payload.size(), block);
+    }
+
+    metrics.m_headerBytes = block.size();
+    metrics.m_containerBytes = block.size() + payloadBytes;
+    block.reserve(metrics.m_containerBytes);
+
+    for (const std::vector<uint8_t>& payload : payloads)
+    {
+        block.insert(block.end(), payload.begin(), payload.end());
+    }
+
+    return std::make_pair(block, metrics);
+}
+
+/* Кодирование текста в алфавите кодовых точек. Размер блока известен до
+   упаковки битов: если он не меньше байтового или хранимого блока, текст
+   кодируется обычным Encode */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeUtf8(const std::string& text, bool checksum)
+{
+    Utf8Alphabet alphabet;
+    std::vector<uint64_t> frequencies;
+    alphabet.Build(text, frequencies);
+
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(frequencies);
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+    CompressionMetrics metrics = CompressionMetrics::Calculate(frequencies, codeLengths);
+
+    std::vector<uint8_t> block;
+    WriteType(Utf8, text, checksum, block);
+    WriteVarint(text.size(), block);
+    WriteVarint(alphabet.GetCodePoints().size(), block);
+
+    uint32_t previousCodePoint = 0x7F;
+
+    for (uint32_t codePoint : alphabet.GetCodePoints())
+    {
+        WriteVarint(codePoint - previousCodePoint - 1, block);
+        previousCodePoint = codePoint;
+    }
+
+    int usedSymbols = 0;
+    int maxLength = 0;
+
+    for (int length : codeLengths)
+    {
+        usedSymbols += (length > 0);
+        maxLength = std::max(maxLength, length);
+    }
+
+    WriteVarint(usedSymbols, block);
+    int previousSymbol = -1;
+
+    for (size_t symbol = 0; symbol < codeLengths.size(); symbol++)
+    {
+        if (codeLengths[symbol] > 0)
+        {
+            WriteVarint(symbol - previousSymbol - 1, block);
+            block.push_back(static_cast<uint8_t>(codeLengths[symbol]));
+            previousSymbol = static_cast<int>(symbol);
+        }
+    }
+
+    size_t payloadBytes = static_cast<size_t>((metrics.m_payloadBits + 7) / 8);
+    WriteVarint(payloadBytes, block);
+
+    size_t byteBlockSize = std::min(EstimateMetrics(HuffmanKernels::CountBytes(text)).m_containerBytes, StoredSize(text.size())) + (checksum ? ChecksumBytes : 0);
+
+    if (alphabet.GetCodePoints().empty() || maxLength > BitWriter::MaxWriteBits || block.size() + payloadBytes >= byteBlockSize)
+    {
+        return Encode(text, CompressibilityEstimator(), checksum);
+    }
+
+    HuffmanTree canonicalTree;
+    canonicalTree.BuildFromCodeLengths(codeLengths);
+    std::vector<HuffmanTree::Code> codeTable = canonicalTree.BuildPackedCodeTable();
+    BitWriter writer(payloadBytes);
+
+    for (size_t position = 0; position < text.size(); )
+    {
+        const HuffmanTree::Code& code = codeTable[alphabet.NextSymbol(text, position)];
+        writer.WriteBits(code.m_bits, code.m_length);
+    }
+
+    std::vector<uint8_t> payload = writer.Finish();
+    block.insert(block.end(), payload.begin(), payload.end());
+
+    /* Символы блока - кодовые точки, а коэффициент сжатия считается
+       по байтам текста */
+    metrics.m_symbolCount = text.size();
+    metrics.m_headerBytes = block.size() - payload.size();
+    metrics.m_containerBytes = block.size();
+
+    return std::make_pair(block, metrics);
+}
+
+/* Блок tANS независимо от оценки. Текст из одного символа tANS
+   не кодирует - для него получается обычный блок */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeTans(const std::string& text, bool checksum)
+{
+    std::vector<uint64_t> frequencies = HuffmanKernels::CountBytes(text);
+    std::vector<int> counts = TansCoder::NormalizeCounts(frequencies, TansCoder::DefaultTableLog);
+
+    if (counts.empty())
+    {
+        return Encode(text, CompressibilityEstimator(), checksum);
+    }
+
+    return EncodeTans(text, counts, EstimateMetrics(frequencies), checksum);
+}
+
+/* Блок tANS по нормированным частотам. Граница Шеннона берётся из
+   показателей блока Хаффмана, длина данных и избыточность - свои */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeTans(const std::string& text, const std::vector<int>& counts, CompressionMetrics metrics, bool checksum)
+{
+    TansCoder coder(counts, TansCoder::DefaultTableLog);
+    BitWriter writer(text.size() / 2);
+    coder.Encode(text.data(), text.size(), writer);
+    metrics.m_payloadBits = writer.BitCount();
+
+    std::vector<uint8_t> payload = writer.Finish();
+    std::vector<uint8_t> block;
+    WriteType(Tans, text, checksum, block);
+    WriteVarint(text.size(), block);
+    block.push_back(static_cast<uint8_t>(TansCoder::DefaultTableLog));
+
+    WriteVarint(std::count_if(counts.begin(), counts.end(), [](int count) { return count > 0; }), block);
+
+    for (size_t symbol = 0; symbol < counts.size(); symbol++)
+    {
+        if (counts[symbol] > 0)
+        {
+            block.push_back(static_cast<uint8_t>(symbol));
+            WriteVarint(counts[symbol] - 1, block);
+        }
+    }
+
+    WriteVarint(payload.size(), block);
+    block.insert(block.end(), payload.begin(), payload.end());
+
+    metrics.m_headerBytes = block.size() - payload.size();
+    metrics.m_containerBytes = block.size();
+
+    if (metrics.m_symbolCount > 0)
+    {
+        metrics.m_redundancy = (metrics.m_payloadBits - metrics.m_entropyBits) / metrics.m_symbolCount;
+    }
+
+    return std::make_pair(block, metrics);
+}
+
+/* Блок LZ77. Если он по размеру не меньше байтового блока по оценке
+   или хранимого, текст кодируется обычным Encode. Граница Шеннона
+   в показателях - байтовая, как у Encode: на тексте с повторами данные
+   блока LZ77 короче неё, и избыточность отрицательна */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeLz(const std::string& text, int windowBits, int level, bool checksum)
+{
+    if (text.empty() || text.size() > Lz77Coder::MaxTextBytes)
+    {
+        return Encode(text, CompressibilityEstimator(), checksum);
+    }
+
+    Lz77Coder coder(windowBits, level);
+    std::vector<Lz77Coder::Token> tokens = coder.Parse(text);
+    std::vector<uint64_t> literalFrequencies;
+    std::vector<uint64_t> distanceFrequencies;
+    coder.CountSymbols(tokens, literalFrequencies, distanceFrequencies);
+
+    HuffmanTree literalTree;
+    HuffmanTree distanceTree;
+    literalTree.BuildHuffmanTree(literalFrequencies);
+    distanceTree.BuildHuffmanTree(distanceFrequencies);
+    std::vector<int> literalLengths = literalTree.BuildCodeLengths();
+    std::vector<int> distanceLengths = distanceTree.BuildCodeLengths();
+
+    if (*std::max_element(literalLengths.begin(), literalLengths.end()) > BitWriter::MaxWriteBits || *std::max_element(distanceLengths.begin(), distanceLengths.end()) > BitWriter::MaxWriteBits)
+    {
+        return Encode(text, CompressibilityEstimator(), checksum);
+    }
+
+    HuffmanTree literalCanonical;
+    HuffmanTree distanceCanonical;
+    literalCanonical.BuildFromCodeLengths(literalLengths);
+    distanceCanonical.BuildFromCodeLengths(distanceLengths);
+    std::vector<HuffmanTree::Code> literalCodes = literalCanonical.BuildPackedCodeTable();
+    std::vector<HuffmanTree::Code> distanceCodes = distanceCanonical.BuildPackedCodeTable();
+
+    BitWriter writer(text.size() / 2);
+    Lz77Coder::EncodeTokens(tokens, literalCodes.data(), distanceCodes.data(), writer);
+    uint64_t payloadBits = writer.BitCount();
+    std::vector<uint8_t> payload = writer.Finish();
+
+    std::vector<uint8_t> block;
+    WriteType(Lz, text, checksum, block);
+    WriteVarint(text.size(), block);
+    block.push_back(static_cast<uint8_t>(coder.WindowBits()));
+    WriteSymbolCodeLengths(literalLengths, block);
+    WriteSymbolCodeLengths(distanceLengths, block);
+    WriteVarint(payload.size(), block);
+
+    CompressionMetrics metrics = EstimateMetrics(HuffmanKernels::CountBytes(text));
+
+    if (block.size() + payload.size() >= std::min(metrics.m_containerBytes, StoredSize(text.size())) + (checksum ? ChecksumBytes : 0))
+    {
+        return Encode(text, CompressibilityEstimator(), checksum);
+    }
+
+    block.insert(block.end(), payload.begin(), payload.end());
+    metrics.m_payloadBits = payloadBits;
+    metrics.m_headerBytes = block.size() - payload.size();
+    metrics.m_containerBytes = block.size();
+    metrics.m_redundancy = (metrics.m_payloadBits - metrics.m_entropyBits) / metrics.m_symbolCount;
+
+    return std::make_pair(block, metrics);
+}
+
+/* Хранимый блок. Гистограмма для него не строится, поэтому граница
+   Шеннона и избыточность в показателях остаются нулевыми */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanBlock::EncodeStored(const std::string& text, bool checksum)
+{
+    std::vector<uint8_t> block;
+    block.reserve(StoredSize(text.size()) + (checksum ? ChecksumBytes : 0));
+
+    WriteType(Stored, text, checksum, block);
+    WriteVarint(text.size(), block);
+    block.insert(block.end(), text.begin(), text.end());
+
+    CompressionMetrics metrics;
+    metrics.m_symbolCount = text.size();
+    metrics.m_payloadBits = static_cast<uint64_t>(text.size()) * 8;
+    metrics.m_headerBytes = block.size() - text.size();
+    metrics.m_containerBytes = block.size();
+
+    return std::make_pair(block, metrics);
+}
+
+/* Байт типа и, если нужна, контрольная сумма исходного текста */
+void HuffmanBlock::WriteType(BlockType type, const std::string& text, bool checksum, std::vector<uint8_t>& block)
+{
+    if (!checksum)
+    {
+        block.push_back(type);
+
+        return;
+    }
+
+    block.push_back(type | ChecksumFlag);
+    uint32_t crc = Crc32c::Calculate(text.data(), text.size());
+
+    for (int byte = 0; byte < ChecksumBytes; byte++)
+    {
+        block.push_back(static_cast<uint8_t>(crc >> (8 * byte)));
+    }
+}
+
+/* Число используемых символов и пары (символ, длина кода) */
+void HuffmanBlock::WriteCodeLengths(const std::vector<int>& codeLengths, std::vector<uint8_t>& block)
+{
+    int usedSymbols = 0;
+
+    for (int length : codeLengths)
+    {
+        usedSymbols += (length > 0);
+    }
+
+    WriteVarint(usedSymbols, block);
+
+    for (size_t symbol = 0; symbol < codeLengths.size(); symbol++)
+    {
+        if (codeLengths[symbol] > 0)
+        {
+            block.push_back(static_cast<uint8_t>(symbol));
+            block.push_back(static_cast<uint8_t>(codeLengths[symbol]));
+        }
+    }
+}
+
+/* Длины кодов большого алфавита: число используемых символов и пары
+   (varint разности номеров минус 1, байт длины), как у блока кодовых точек */
+void HuffmanBlock::WriteSymbolCodeLengths(const std::vector<int>& codeLengths, std::vector<uint8_t>& block)
+{
+    WriteVarint(std::count_if(codeLengths.begin(), codeLengths.end(), [](int length) { return length > 0; }), block);
+    int previousSymbol = -1;
+
+    for (size_t symbol = 0; symbol < codeLengths.size(); symbol++)
+    {
+        if (codeLengths[symbol] > 0)
+        {
+            WriteVarint(symbol - previousSymbol - 1, block);
+            block.push_back(static_cast<uint8_t>(codeLengths[symbol]));
+            previousSymbol = static_cast<int>(symbol);
+        }
+    }
+}
+
+/* Чтение длин, записанных WriteSymbolCodeLengths, в codeLengths
+   заданного размера алфавита */
+bool HuffmanBlock::ReadSymbolCodeLengths(const std::vector<uint8_t>& block, size_t& position, std::vector<int>& codeLengths)
+{
+    uint64_t usedSymbols = 0;
+
+    if (!ReadVarint(block, position, usedSymbols) || usedSymbols > codeLengths.size() || usedSymbols * 2 > block.size() - position)
+    {
+        return false;
+    }
+
+    uint64_t symbol = static_cast<uint64_t>(-1);
+
+    for (uint64_t used = 0; used < usedSymbols; used++)
+    {
+        uint64_t delta;
+
+        if (!ReadVarint(block, position, delta) || delta >= codeLengths.size() || position == block.size())
+        {
+            return false;
+        }
+
+        symbol += delta + 1;
+        int length = block[position++];
+
+        if (symbol >= codeLengths.size() || length == 0 || length > BitWriter::MaxWriteBits)
+        {
+            return false;
+        }
+
+        codeLengths[static_cast<size_t>(symbol)] = length;
+    }
+
+    return true;
+}
+
+bool HuffmanBlock::HasChecksum(const std::vector<uint8_t>& block)
+{
+    return !block.empty() && (block[0] & ChecksumFlag) != 0;
+}
+
+/* Декодирование блока. Контрольная сумма, если есть, сверяется
+   с декодированным текстом: одного прохода по результату, пока он
+   ещё в кэше, достаточно, чтобы декодер оставался без изменений */
+bool HuffmanBlock::Decode(const std::vector<uint8_t>& block, std::string& decodedText)
+{
+    if (!DecodeUnchecked(block, decodedText))
+    {
+        return false;
+    }
+
+    if (!HasChecksum(block))
+    {
+        return true;
+    }
+
+    uint32_t expected = 0;
+
+    for (int byte = 0; byte < ChecksumBytes; byte++)
+    {
+        expected |= static_cast<uint32_t>(block[1 + byte]) << (8 * byte);
+    }
+
+    return Crc32c::Calculate(decodedText.data(), decodedText.size()) == expected;
+}
+
+bool HuffmanBlock::DecodeUnchecked(const std::vector<uint8_t>& block, std::string& decodedText)
+{
+    size_t position = 0;
+    uint64_t symbolCount = 0;
+    uint64_t usedSymbols = 0;
+    uint64_t payloadBytes = 0;
+
+    if (block.empty() || (block[position] & ~ChecksumFlag) > Lz)
+    {
+        return false;
+    }
+
+    BlockType type = static_cast<BlockType>(block[position++] & ~ChecksumFlag);
+
+    if (HasChecksum(block))
+    {
+        if (block.size() < 1 + ChecksumBytes)
+        {
+            return false;
+        }
+
+        position += ChecksumBytes;
+    }
+
+    if (!ReadVarint(block, position, symbolCount))
+    {
+        return false;
+    }
+
+    if (type == Utf8)
+    {
+        return DecodeUtf8(block, position, symbolCount, decodedText);
+    }
+
+    if (type == Tans)
+    {
+        return DecodeTans(block, position, symbolCount, decodedText);
+    }
+
+    if (type == Lz)
+    {
+        return DecodeLz(block, position, symbolCount, decodedText);
+    }
+
+    if (type == Stored)
+    {
+        if (block.size() - position != symbolCount)
+        {
+            return false;
+        }
+
+        decodedText.assign(block.begin() + position, block.end());
+
+        return true;
+    }
+
+    if (!ReadVarint(block, position, usedSymbols) || usedSymbols > 256)
+    {
+        return false;
+    }
+
+    if (block.size() - position < usedSymbols * 2)
+    {
+        return false;
+    }
+
+    std::vector<int> codeLengths(256, 0);
+    int minLength = BitWriter::MaxWriteBits;
+
+    for (uint64_t used = 0; used < usedSymbols; used++)
+    {
+        int symbol = block[position++];
+        int length = block[position++];
+
+        if (codeLengths[symbol] != 0 || length == 0 || length > BitWriter::MaxWriteBits)
+        {
+            return false;
+        }
+
+        codeLengths[symbol] = length;
+        minLength = std::min(minLength, length);
+    }
+
+    /* Длины потоков блока с чередованием; у байтового блока поток один */
+    std::vector<size_t> laneSizes;
+
+    if (type == Interleaved)
+    {
+        if (position == block.size())
+        {
+            return false;
+        }
+
+        int laneCount = block[position++];
+
+        if (laneCount != 8 && laneCount != 16)
+        {
+            return false;
+        }
+
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            uint64_t laneBytes;
+
+            if (!ReadVarint(block, position, laneBytes) || laneBytes > block.size())
+            {
+                return false;
+            }
+
+            laneSizes.push_back(static_cast<size_t>(laneBytes));
+            payloadBytes += laneBytes;
+        }
+
+        if (block.size() - position != payloadBytes)
+        {
+            return false;
+        }
+    }
+    else if (!ReadVarint(block, position, payloadBytes) || block.size() - position != payloadBytes)
+    {
+        return false;
+    }
+
+    /* Каждый символ занимает хотя бы minLength битов: ограничивает размер
+       результата до выделения памяти */
+    if (symbolCount > 0 && (usedSymbols == 0 || symbolCount > payloadBytes * 8 / minLength))
+    {
+        return false;
+    }
+
+    /* Кодер строит только полные коды: неполный код из файла оставил бы
+       быстрому декодеру пути без символа */
+    HuffmanTree tree;
+
+    if (!HuffmanTree::CheckKraft(codeLengths, true) || !tree.BuildFromCodeLengths(codeLengths))
+    {
+        return false;
+    }
+
+    HuffmanDecodeTable decodeTable(tree);
+
+    if (type == Interleaved)
+    {
+        return decodeTable.DecodeInterleaved(block.data() + position, laneSizes, symbolCount, decodedText) == HuffmanTree::DecodeSuccess;
+    }
+
+    return decodeTable.Decode(block.data() + position, payloadBytes, symbolCount, decodedText) == HuffmanTree::DecodeSuccess;
+}
+
+/* Заголовок блока кодовых точек после длины текста и данные. Число точек
+   и символов сверяется с оставшимися байтами до выделения памяти */
+bool HuffmanBlock::DecodeUtf8(const std::vector<uint8_t>& block, size_t position, uint64_t byteCount, std::string& decodedText)
+{
+    uint64_t codePointCount = 0;
+    uint64_t usedSymbols = 0;
+    uint64_t payloadBytes = 0;
+
+    if (!ReadVarint(block, position, codePointCount) || codePointCount > block.size() - position)
+    {
+        return false;
+    }
+
+    std::vector<uint32_t> codePoints(static_cast<size_t>(codePointCount));
+    uint64_t codePoint = 0x7F;
+
+    for (uint32_t& point : codePoints)
+    {
+        uint64_t delta;
+
+        if (!ReadVarint(block, position, delta) || delta > Utf8Alphabet::MaxCodePoint)
+        {
+            return false;
+        }
+
+        codePoint += delta + 1;
+
+        if (codePoint > Utf8Alphabet::MaxCodePoint)
+        {
+            return false;
+        }
+
+        point = static_cast<uint32_t>(codePoint);
+    }
+
+    Utf8Alphabet alphabet;
+
+    if (!alphabet.Assign(codePoints))
+    {
+        return false;
+    }
+
+    if (!ReadVarint(block, position, usedSymbols) || usedSymbols > alphabet.Size() || usedSymbols * 2 > block.size() - position)
+    {
+        return false;
+    }
+
+    std::vector<int> codeLengths(alphabet.Size(), 0);
+    uint64_t symbol = static_cast<uint64_t>(-1);
+
+    for (uint64_t used = 0; used < usedSymbols; used++)
+    {
+        uint64_t delta;
+
+        if (!ReadVarint(block, position, delta) || delta >= alphabet.Size() || position == block.size())
+        {
+            return false;
+        }
+
+        symbol += delta + 1;
+        int length = block[position++];
+
+        if (symbol >= alphabet.Size() || length == 0 || length > BitWriter::MaxWriteBits)
+        {
+            return false;
+        }
+
+        codeLengths[static_cast<size_t>(symbol)] = length;
+    }
+
+    if (!ReadVarint(block, position, payloadBytes) || block.size() - position != payloadBytes)
+    {
+        return false;
+    }
+
+    HuffmanTree tree;
+
+    if (!HuffmanTree::CheckKraft(codeLengths, true) || !tree.BuildFromCodeLengths(codeLengths))
+    {
+        return false;
+    }
+
+    Utf8DecodeTable decodeTable(tree, alphabet);
+
+    return decodeTable.Decode(block.data() + position, payloadBytes, byteCount, decodedText) == HuffmanTree::DecodeSuccess;
+}
+
+/* Заголовок блока tANS после длины текста и данные. Частоты
+   проверяются целиком до построения таблиц */
+bool HuffmanBlock::DecodeTans(const std::vector<uint8_t>& block, size_t position, uint64_t symbolCount, std::string& decodedText)
+{
+    uint64_t usedSymbols = 0;
+    uint64_t payloadBytes = 0;
+
+    if (position == block.size())
+    {
+        return false;
+    }
+
+    int tableLog = block[position++];
+
+    if (tableLog < TansCoder::MinTableLog || tableLog > TansCoder::MaxTableLog)
+    {
+        return false;
+    }
+
+    if (!ReadVarint(block, position, usedSymbols) || usedSymbols > 256 || usedSymbols * 2 > block.size() - position)
+    {
+        return false;
+    }
+
+    std::vector<int> counts(256, 0);
+
+    for (uint64_t used = 0; used < usedSymbols; used++)
+    {
+        uint64_t count;
+
+        if (position == block.size())
+        {
+            return false;
+        }
+
+        int symbol = block[position++];
+
+        if (!ReadVarint(block, position, count) || count >= (uint64_t(1) << tableLog) || counts[symbol] != 0)
+        {
+            return false;
+        }
+
+        counts[symbol] = static_cast<int>(count) + 1;
+    }
+
+    if (!TansCoder::CheckCounts(counts, tableLog))
+    {
+        return false;
+    }
+
+    if (!ReadVarint(block, position, payloadBytes) || block.size() - position != payloadBytes)
+    {
+        return false;
+    }
+
+    TansCoder coder(counts, tableLog);
+
+    return coder.Decode(block.data() + position, payloadBytes, symbolCount, decodedText) == HuffmanTree::DecodeSuccess;
+}
+
+/* Заголовок блока LZ77 после длины текста и данные. Оба кода должны быть
+   полными; алфавит расстояний может быть пустым, если совпадений нет */
+bool HuffmanBlock::DecodeLz(const std::vector<uint8_t>& block, size_t position, uint64_t textLength, std::string& decodedText)
+{
+    uint64_t payloadBytes = 0;
+
+    if (position == block.size())
+    {
+        return false;
+    }
+
+    int windowBits = block[position++];
+
+    if (windowBits < Lz77Coder::MinWindowBits || windowBits > Lz77Coder::MaxWindowBits)
+    {
+        return false;
+    }
+
+    std::vector<int> literalLengths(Lz77Coder::LiteralSymbols, 0);
+    std::vector<int> distanceLengths(Lz77Coder::DistanceSymbols(windowBits), 0);
+
+    if (!ReadSymbolCodeLengths(block, position, literalLengths) || !ReadSymbolCodeLengths(block, position, distanceLengths))
+    {
+        return false;
+    }
+
+    if (!ReadVarint(block, position, payloadBytes) || block.size() - position != payloadBytes)
+    {
+        return false;
+    }
+
+    HuffmanTree literalTree;
+    HuffmanTree distanceTree;
+
+    if (!HuffmanTree::CheckKraft(literalLengths, true) || !HuffmanTree::CheckKraft(distanceLengths, true) || !literalTree.BuildFromCodeLengths(literalLengths) || !distanceTree.BuildFromCodeLengths(distanceLengths))
+    {
+        return false;
+    }
+
+    return Lz77Coder::Decode(block.data() + position, payloadBytes, textLength, literalTree, distanceTree, decodedText) == HuffmanTree::DecodeSuccess;
+}
+
+/* Показатели блока по гистограмме: строится только дерево, без кодирования */
+CompressionMetrics HuffmanBlock::EstimateMetrics(const std::vector<uint64_t>& frequencies)
+{
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(frequencies);
+
+    return CompressionMetrics::Calculate(frequencies, tree.BuildCodeLengths());
+}
+
+size_t HuffmanBlock::HeaderSize(uint64_t symbolCount, const std::vector<int>& codeLengths, size_t payloadBytes)
+{
+    size_t usedSymbols = 0;
+
+    for (int length : codeLengths)
+    {
+        usedSymbols += (length > 0);
+    }
+
+    return 1 + VarintSize(symbolCount) + VarintSize(usedSymbols) + usedSymbols * 2 + VarintSize(payloadBytes);
+}
+
+size_t HuffmanBlock::TansHeaderSize(uint64_t symbolCount, const std::vector<int>& counts, size_t payloadBytes)
+{
+    size_t size = 1 + VarintSize(symbolCount) + 1 + VarintSize(payloadBytes);
+    size_t usedSymbols = 0;
+
+    for (int count : counts)
+    {
+        if (count > 0)
+        {
+            size += 1 + VarintSize(count - 1);
+            usedSymbols++;
+        }
+    }
+
+    return size + VarintSize(usedSymbols);
+}
+
+size_t HuffmanBlock::StoredSize(uint64_t symbolCount)
+{
+    return 1 + VarintSize(symbolCount) + symbolCount;
+}
+
+/* Целые переменной длины: по 7 битов в байте, старший бит - "есть продолжение" */
+void HuffmanBlock::WriteVarint(uint64_t value, std::vector<uint8_t>& output)
+{
+    while (value >= 0x80)
+    {
+        output.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+bool HuffmanBlock::ReadVarint(const std::vector<uint8_t>& input, size_t& position, uint64_t& value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64 && position < input.size(); shift += 7)
+    {
+        uint8_t byte = input[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t HuffmanBlock::VarintSize(uint64_t value)
+{
+    size_t size = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+
+    return size;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CompressionMetrics.h"
+#include "CompressibilityEstimator.h"
+
+/* Блок сжатых данных: самодостаточный формат, который декодируется без
+   исходного дерева.
+
+       байт      тип блока (Huffman), старший бит - флаг ChecksumFlag
+       4 байта   CRC32C декодированного текста, little-endian (только с флагом)
+       varint    число символов
+       varint    число используемых символов n
+       n пар     (символ, длина кода) в порядке возрастания символа
+       varint    длина данных в байтах
+       данные    упакованные биты канонических кодов, дополнение нулями
+
+   Коды канонические (как в DEFLATE): по длинам кодов декодер восстанавливает
+   те же коды, поэтому само дерево не передаётся.
+
+   Блок кодовых точек (Utf8) кодирует текст в алфавите Utf8Alphabet:
+
+       байт      тип блока (Utf8), флаг и CRC32C - как выше
+       varint    длина текста в байтах
+       varint    число кодовых точек k
+       k varint  кодовые точки по возрастанию: первая - разность с 0x80,
+                 следующие - разность с предыдущей минус 1
+       varint    число используемых символов n
+       n пар     (varint разности номера символа с предыдущим минус 1,
+                 байт длины кода); номер первого символа - сама разность
+       varint    длина данных в байтах
+       данные    упакованные биты канонических кодов
+
+   Блок с чередующимися потоками (Interleaved) - байтовый блок, символы
+   которого разнесены по 8 или 16 независимым потокам: символ i - в потоке
+   i % числа потоков. Потоки декодируются параллельно (HuffmanDecodeTable::
+   DecodeInterleaved):
+
+       байт      тип блока (Interleaved), флаг и CRC32C - как выше
+       varint    число символов
+       varint    число используемых символов n
+       n пар     (символ, длина кода) в порядке возрастания символа
+       байт      число потоков
+       varint    длина данных каждого потока в байтах
+       данные    упакованные биты потоков друг за другом
+
+   Блок tANS (Tans) кодирует байты табличным ANS (TansCoder) вместо кодов
+   Хаффмана. Encode выбирает его сам, если по оценке он заметно меньше:
+
+       байт      тип блока (Tans), флаг и CRC32C - как выше
+       varint    число символов
+       байт      tableLog: частоты нормированы к сумме 2^tableLog
+       varint    число используемых символов n
+       n пар     (символ, varint частоты минус 1) в порядке возрастания символа
+       varint    длина данных в байтах
+       данные    конечные состояния кодера и биты символов
+
+   Блок LZ77 (Lz) - литералы и совпадения Lz77Coder с двумя деревьями
+   Хаффмана, как в DEFLATE; выбирается только явно (EncodeLz):
+
+       байт      тип блока (Lz), флаг и CRC32C - как выше
+       varint    длина текста
+       байт      windowBits: расстояния меньше 2^windowBits
+       varint    число используемых символов алфавита литералов и длин n
+       n пар     (varint разности номера символа с предыдущим минус 1,
+                 байт длины кода), как у блока кодовых точек
+       varint    число используемых символов алфавита расстояний и пары
+                 в том же виде
+       varint    длина данных в байтах
+       данные    коды литералов и совпадений с дополнительными битами
+
+   Несжимаемые данные сохраняются хранимым блоком: байт типа (Stored),
+   контрольная сумма при флаге, varint длины и сами байты.
+
+   Контрольная сумма необязательна и проверяется при декодировании:
+   повреждённый блок отвергается без сравнения с исходным текстом. */
+class HuffmanBlock
+{
+public:
+    enum BlockType : uint8_t
+    {
+        Stored = 0,
+        Huffman = 1,
+        Utf8 = 2,                                                                                       // Алфавит кодовых точек UTF-8
+        Interleaved = 3,                                                                                // Символы в чередующихся потоках
+        Tans = 4,                                                                                       // Табличный ANS вместо кодов Хаффмана
+        Lz = 5                                                                                          // Совпадения LZ77 и два дерева
+    };
+
+    enum : uint8_t
+    {
+        ChecksumFlag = 0x80,                                                                            // Флаг в байте типа: за ним идёт CRC32C
+        ChecksumBytes = 4
+    };
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> Encode(const std::string& text);         // Кодирование текста в блок
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> Encode(const std::string& text, const CompressibilityEstimator& estimator, bool checksum = false);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeUtf8(const std::string& text, bool checksum = false);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeInterleaved(const std::string& text, int laneCount = 16, bool checksum = false);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeTans(const std::string& text, bool checksum = false);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeLz(const std::string& text, int windowBits, int level, bool checksum = false);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeStored(const std::string& text, bool checksum = false);
+
+    static bool Decode(const std::vector<uint8_t>& block, std::string& decodedText);                    // Декодирование блока (false - блок повреждён)
+
+    static bool HasChecksum(const std::vector<uint8_t>& block);                                         // Блок несёт CRC32C
+
+    static CompressionMetrics EstimateMetrics(const std::vector<uint64_t>& frequencies);                // Показатели без кодирования
+
+    static size_t HeaderSize(uint64_t symbolCount, const std::vector<int>& codeLengths, size_t payloadBytes);
+
+    static size_t StoredSize(uint64_t symbolCount);                                                     // Размер хранимого блока
+
+    static size_t TansHeaderSize(uint64_t symbolCount, const std::vector<int>& counts, size_t payloadBytes);
+
+    static void WriteVarint(uint64_t value, std::vector<uint8_t>& output);
+
+    static bool ReadVarint(const std::vector<uint8_t>& input, size_t& position, uint64_t& value);
+
+    static size_t VarintSize(uint64_t value);
+
+private:
+    static void WriteType(BlockType type, const std::string& text, bool checksum, std::vector<uint8_t>& block);
+
+    static void WriteCodeLengths(const std::vector<int>& codeLengths, std::vector<uint8_t>& block);     // Число символов и пары (символ, длина)
+
+    static void WriteSymbolCodeLengths(const std::vector<int>& codeLengths, std::vector<uint8_t>& block);
+
+    static bool ReadSymbolCodeLengths(const std::vector<uint8_t>& block, size_t& position, std::vector<int>& codeLengths);
+
+    static bool DecodeUnchecked(const std::vector<uint8_t>& block, std::string& decodedText);           // Декодирование без сверки CRC32C
+
+    static bool DecodeUtf8(const std::vector<uint8_t>& block, size_t position, uint64_t byteCount, std::string& decodedText);
+
+    static std::pair<std::vector<uint8_t>, CompressionMetrics> EncodeTans(const std::string& text, const std::vector<int>& counts, CompressionMetrics metrics, bool checksum);
+
+    static bool DecodeTans(const std::vector<uint8_t>& block, size_t position, uint64_t symbolCount, std::string& decodedText);
+
+    static bool DecodeLz(const std::vector<uint8_t>& block, size_t position, uint64_t textLength, std::string& decodedText);
+};
@@ -0,0 +1,578 @@
+#include "HuffmanDecodeTable.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/* Построение таблицы: сначала односимвольные записи по кодам длиной
+   до LookupBits, затем к каждой записи дописываются следующие символы,
+   пока их коды помещаются в оставшиеся биты индекса */
+HuffmanDecodeTable::HuffmanDecodeTable(const HuffmanTree& tree)
+    : m_entries(1 << LookupBits, Entry{ { 0, 0, 0, 0 }, 0, 0, 0 }), m_laneEntries(1 << LookupBits, 0), m_tree(tree.BuildFlatTree())
+{
+    const int tableMask = (1 << LookupBits) - 1;
+    std::vector<HuffmanTree::Code> codeTable = tree.BuildPackedCodeTable();
+    std::vector<int> symbols(1 << LookupBits, -1);
+    std::vector<int> lengths(1 << LookupBits, 0);
+
+    for (int symbol = 0; symbol < static_cast<int>(codeTable.size()); symbol++)
+    {
+        const HuffmanTree::Code& code = codeTable[symbol];
+
+        if (code.m_length > 0 && (m_minLength == 0 || code.m_length < m_minLength))
+        {
+            m_minLength = code.m_length;
+        }
+
+        if (code.m_length == 0 || code.m_length > LookupBits)
+        {
+            continue;
+        }
+
+        int first = static_cast<int>(code.m_bits << (LookupBits - code.m_length));
+        int last = first + (1 << (LookupBits - code.m_length));
+
+        for (int index = first; index < last; index++)
+        {
+            symbols[index] = symbol;
+            lengths[index] = code.m_length;
+        }
+    }
+
+    for (int index = 0; index <= tableMask; index++)
+    {
+        Entry& entry = m_entries[index];
+        int used = 0;
+
+        while (entry.m_count < MaxSymbolsPerEntry)
+        {
+            int next = (index << used) & tableMask;
+
+            if (symbols[next] < 0 || lengths[next] > LookupBits - used)
+            {
+                break;
+            }
+
+            entry.m_symbols[entry.m_count++] = static_cast<uint8_t>(symbols[next]);
+            used += lengths[next];
+        }
+
+        entry.m_bits = static_cast<uint8_t>(used);
+        entry.m_firstBits = static_cast<uint8_t>(lengths[index]);
+        m_laneEntries[index] = (entry.m_count > 0) ? entry.m_symbols[0] | static_cast<uint32_t>(entry.m_firstBits) << 8 : 0;
+    }
+}
+
+/* Декодирование. Запись копируется целиком (4 байта) независимо от числа
+   символов в ней, поэтому у результата есть запас в MaxSymbolsPerEntry байт.
+   Последние символы декодируются по одному, чтобы не выйти за symbolCount.
+   Проверки вынесены из основного цикла: число символов ограничивается до
+   выделения памяти, неверный код уходит в обход дерева, а чтение за концом
+   данных (BitReader отдаёт нули) проверяется один раз в конце. При ошибке
+   результат пуст */
+std::string HuffmanDecodeTable::Decode(const std::vector<uint8_t>& data, size_t symbolCount) const
+{
+    return Decode(data.data(), data.size(), symbolCount);
+}
+
+std::string HuffmanDecodeTable::Decode(const uint8_t* data, size_t size, size_t symbolCount) const
+{
+    std::string decodedText;
+    Decode(data, size, symbolCount, decodedText);
+
+    return decodedText;
+}
+
+HuffmanTree::DecodeStatus HuffmanDecodeTable::Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const
+{
+    return Decode(CpuFeatures::Best(), data, size, symbolCount, decodedText);
+}
+
+/* Общие проверки и выбор основного цикла для уровня isa (уровень выше
+   доступного понижается) */
+HuffmanTree::DecodeStatus HuffmanDecodeTable::Decode(CpuFeatures::Isa isa, const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    if (symbolCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (m_minLength == 0)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    if (symbolCount > size * 8 / m_minLength)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    decodedText.resize(symbolCount + MaxSymbolsPerEntry);
+    HuffmanTree::DecodeStatus status;
+
+#if defined(__x86_64__)
+    if (std::min(isa, CpuFeatures::Best()) == CpuFeatures::Bmi2)
+    {
+        status = DecodeBmi2(data, size, symbolCount, &decodedText[0]);
+    }
+    else
+#endif
+    {
+        BitReader reader(data, size);
+        status = DecodeFrom(reader, 0, symbolCount, &decodedText[0]);
+    }
+
+    if (status != HuffmanTree::DecodeSuccess)
+    {
+        decodedText.clear();
+
+        return status;
+    }
+
+    decodedText.resize(symbolCount);
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+/* Декодирование symbolCount символов в output с текущего бита reader,
+   переносимым циклом. Reader остаётся за последним кодом, так что поток
+   можно продолжить другими данными или другой таблицей */
+HuffmanTree::DecodeStatus HuffmanDecodeTable::Decode(BitReader& reader, size_t symbolCount, char* output) const
+{
+    if (symbolCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (m_minLength == 0)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    return DecodeFrom(reader, 0, symbolCount, output);
+}
+
+/* Переносимый цикл с позиции position до symbolCount */
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeFrom(BitReader& reader, size_t position, size_t symbolCount, char* output) const
+{
+    while (position + MaxSymbolsPerEntry <= symbolCount)
+    {
+        reader.Refill();
+        const Entry& entry = m_entries[reader.PeekBits(LookupBits)];
+
+        if (entry.m_count == 0)
+        {
+            if (!DecodeLongSymbol(reader, output[position++]))
+            {
+                return HuffmanTree::InvalidCode;
+            }
+
+            continue;
+        }
+
+        std::memcpy(output + position, entry.m_symbols, MaxSymbolsPerEntry);
+        position += entry.m_count;
+        reader.ConsumeBits(entry.m_bits);
+    }
+
+    while (position < symbolCount)
+    {
+        reader.Refill();
+        const Entry& entry = m_entries[reader.PeekBits(LookupBits)];
+
+        if (entry.m_count == 0)
+        {
+            if (!DecodeLongSymbol(reader, output[position++]))
+            {
+                return HuffmanTree::InvalidCode;
+            }
+
+            continue;
+        }
+
+        output[position++] = static_cast<char>(entry.m_symbols[0]);
+        reader.ConsumeBits(entry.m_firstBits);
+    }
+
+    return reader.IsOverrun() ? HuffmanTree::TruncatedStream : HuffmanTree::DecodeSuccess;
+}
+
+#if defined(__x86_64__)
+/* Цикл BMI2. Вместо накопителя с дозаполнением на каждом символе слово
+   читается заново по адресу bitPosition / 8 раз на GroupEntries записей:
+   после сдвига на bitPosition % 8 в нём не меньше 57 битов, а записи
+   занимают не больше LookupBits битов каждая. Индекс таблицы - старшие
+   биты слова (сдвиг на постоянную), потребление кода - сдвиг на переменную
+   величину, для которого с target("bmi2") компилятор выдаёт SHLX: одна
+   микрооперация без флагов вместо трёх у сдвига на CL. Цепочка
+   зависимостей между записями - загрузка из таблицы и один сдвиг.
+   Длинные коды и последние байты данных декодируются переносимым
+   BitReader, начатым с текущего бита */
+__attribute__((target("bmi,bmi2")))
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeBmi2(const uint8_t* data, size_t size, size_t symbolCount, char* output) const
+{
+    const int GroupEntries = 4;
+    size_t bitPosition = 0;
+    size_t position = 0;
+
+    while (position + GroupEntries * MaxSymbolsPerEntry <= symbolCount && (bitPosition >> 3) + sizeof(uint64_t) <= size)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + (bitPosition >> 3), sizeof(word));
+        uint64_t container = __builtin_bswap64(word) << (bitPosition & 7);
+        bool longCode = false;
+
+        for (int group = 0; group < GroupEntries; group++)
+        {
+            const Entry& entry = m_entries[container >> (64 - LookupBits)];
+
+            if (entry.m_count == 0)
+            {
+                longCode = true;
+                break;
+            }
+
+            std::memcpy(output + position, entry.m_symbols, MaxSymbolsPerEntry);
+            position += entry.m_count;
+            bitPosition += entry.m_bits;
+            container <<= entry.m_bits;
+        }
+
+        if (longCode)
+        {
+            BitReader reader(data + (bitPosition >> 3), size - (bitPosition >> 3));
+            reader.ConsumeBits(static_cast<int>(bitPosition & 7));
+
+            if (!DecodeLongSymbol(reader, output[position++]))
+            {
+                return HuffmanTree::InvalidCode;
+            }
+
+            bitPosition = (bitPosition & ~size_t(7)) + reader.BitPosition();
+        }
+    }
+
+    if (bitPosition > size * 8)
+    {
+        return HuffmanTree::TruncatedStream;
+    }
+
+    BitReader reader(data + (bitPosition >> 3), size - (bitPosition >> 3));
+    reader.ConsumeBits(static_cast<int>(bitPosition & 7));
+
+    return DecodeFrom(reader, position, symbolCount, output);
+}
+#else
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeBmi2(const uint8_t* data, size_t size, size_t symbolCount, char* output) const
+{
+    BitReader reader(data, size);
+
+    return DecodeFrom(reader, 0, symbolCount, output);
+}
+#endif
+
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeInterleaved(const uint8_t* data, const std::vector<size_t>& laneSizes, size_t symbolCount, std::string& decodedText) const
+{
+    return DecodeInterleaved(CpuFeatures::Best(), data, laneSizes, symbolCount, decodedText);
+}
+
+/* Декодирование чередующихся потоков. Проверки те же, что у Decode.
+   Цикл AVX2 идёт, пока у каждого потока есть следующий символ, затем
+   остаток каждого потока декодируется переносимым циклом во временный
+   буфер и раскладывается по своим позициям результата. Без AVX2, при
+   числе потоков не кратном 8 и на данных от 256 МБ (позиции в цикле
+   AVX2 32-битные) так декодируются потоки целиком */
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeInterleaved(CpuFeatures::Isa isa, const uint8_t* data, const std::vector<size_t>& laneSizes, size_t symbolCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    size_t laneCount = laneSizes.size();
+    std::vector<size_t> bitPositions(laneCount);
+    std::vector<size_t> laneEnds(laneCount);
+    size_t size = 0;
+
+    for (size_t lane = 0; lane < laneCount; lane++)
+    {
+        bitPositions[lane] = size * 8;
+        size += laneSizes[lane];
+        laneEnds[lane] = size;
+    }
+
+    if (symbolCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (m_minLength == 0)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    if (laneCount == 0 || symbolCount > size * 8 / m_minLength)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    decodedText.resize(symbolCount);
+    size_t steps = symbolCount / laneCount;
+    size_t step = 0;
+    HuffmanTree::DecodeStatus status = HuffmanTree::DecodeSuccess;
+
+#if defined(__x86_64__)
+    if (std::min(isa, CpuFeatures::Best()) >= CpuFeatures::Avx2 && laneCount % 8 == 0 && laneCount <= MaxLanes && size <= (size_t(1) << 28))
+    {
+        status = DecodeLanesAvx2(data, laneEnds, steps, &decodedText[0], bitPositions, step);
+    }
+#endif
+
+    std::string laneText;
+
+    for (size_t lane = 0; lane < laneCount && status == HuffmanTree::DecodeSuccess; lane++)
+    {
+        size_t remaining = steps + (lane < symbolCount % laneCount) - step;
+        size_t byte = bitPositions[lane] >> 3;
+        BitReader reader(data + byte, laneEnds[lane] - byte);
+        reader.ConsumeBits(static_cast<int>(bitPositions[lane] & 7));
+
+        laneText.resize(remaining + MaxSymbolsPerEntry);
+        status = DecodeFrom(reader, 0, remaining, &laneText[0]);
+
+        for (size_t index = 0; index < remaining; index++)
+        {
+            decodedText[(step + index) * laneCount + lane] = laneText[index];
+        }
+    }
+
+    if (status != HuffmanTree::DecodeSuccess)
+    {
+        decodedText.clear();
+    }
+
+    return status;
+}
+
+#if defined(__x86_64__)
+/* Цикл AVX2 по группам из 8 потоков. Позиции потоков группы - 32-битные
+   номера битов от начала данных в одном регистре. Шаг группы: gather
+   4 байт по адресу позиция / 8 каждого потока, перестановка байтов
+   (старший первым), сдвиг на позицию % 8, индекс - старшие LookupBits
+   битов, gather записей m_laneEntries и прибавление длин кодов
+   к позициям; из того же слова берётся и второй символ потока, так что
+   gather данных приходится на два символа. Младшие байты записей -
+   8 соседних символов результата.
+   Шаг выполняется, только если у всех потоков от текущего байта есть
+   4 байта данных, так что gather не читает за концом потока. Если в
+   группе есть код длиннее LookupBits или неверный код, её шаг делается
+   по одному потоку с обходом дерева */
+__attribute__((target("avx2")))
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeLanesAvx2(const uint8_t* data, const std::vector<size_t>& laneEnds, size_t steps, char* output, std::vector<size_t>& bitPositions, size_t& step) const
+{
+    const int GroupLanes = 8;
+    const int groupCount = static_cast<int>(laneEnds.size()) / GroupLanes;
+    const size_t laneCount = laneEnds.size();
+    const int* dataWords = reinterpret_cast<const int*>(data);
+    const int* table = reinterpret_cast<const int*>(m_laneEntries.data());
+    const __m256i byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i packSymbols = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i joinHalves = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+    const __m256i shiftMask = _mm256_set1_epi32(7);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i positions[MaxLanes / GroupLanes];
+    __m256i limits[MaxLanes / GroupLanes];
+    __m256i words[MaxLanes / GroupLanes];
+    __m256i entries[MaxLanes / GroupLanes];
+    __m256i lengths[MaxLanes / GroupLanes];
+    __m256i secondEntries[MaxLanes / GroupLanes];
+    __m256i secondLengths[MaxLanes / GroupLanes];
+    int32_t lanePositions[GroupLanes];
+    int32_t laneValues[GroupLanes];
+
+    for (int group = 0; group < groupCount; group++)
+    {
+        for (int lane = 0; lane < GroupLanes; lane++)
+        {
+            lanePositions[lane] = static_cast<int32_t>(bitPositions[group * GroupLanes + lane]);
+            laneValues[lane] = static_cast<int32_t>(laneEnds[group * GroupLanes + lane]) - 4;
+        }
+
+        positions[group] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanePositions));
+        limits[group] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(laneValues));
+    }
+
+    while (step < steps)
+    {
+        int beyondEnd = 0;
+        int longCodes = 0;
+
+        for (int group = 0; group < groupCount; group++)
+        {
+            beyondEnd |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_srli_epi32(positions[group], 3), limits[group])));
+        }
+
+        if (beyondEnd != 0)
+        {
+            break;
+        }
+
+        for (int group = 0; group < groupCount; group++)
+        {
+            __m256i word = _mm256_i32gather_epi32(dataWords, _mm256_srli_epi32(positions[group], 3), 1);
+            words[group] = _mm256_sllv_epi32(_mm256_shuffle_epi8(word, byteSwap), _mm256_and_si256(positions[group], shiftMask));
+            entries[group] = _mm256_i32gather_epi32(table, _mm256_srli_epi32(words[group], 32 - LookupBits), 4);
+            lengths[group] = _mm256_srli_epi32(entries[group], 8);
+            longCodes |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lengths[group], zero)));
+        }
+
+        /* Длинный или неверный код: шаг по одному потоку */
+        if (longCodes != 0)
+        {
+            for (int group = 0; group < groupCount; group++)
+            {
+                char* groupOutput = output + step * laneCount + group * GroupLanes;
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanePositions), positions[group]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneValues), entries[group]);
+
+                for (int lane = 0; lane < GroupLanes; lane++)
+                {
+                    if (laneValues[lane] != 0)
+                    {
+                        groupOutput[lane] = static_cast<char>(laneValues[lane]);
+                        lanePositions[lane] += laneValues[lane] >> 8;
+                        continue;
+                    }
+
+                    size_t byte = static_cast<size_t>(lanePositions[lane]) >> 3;
+                    BitReader reader(data + byte, laneEnds[group * GroupLanes + lane] - byte);
+                    reader.ConsumeBits(lanePositions[lane] & 7);
+
+                    if (!DecodeLongSymbol(reader, groupOutput[lane]))
+                    {
+                        return HuffmanTree::InvalidCode;
+                    }
+
+                    if (reader.IsOverrun())
+                    {
+                        return HuffmanTree::TruncatedStream;
+                    }
+
+                    lanePositions[lane] = static_cast<int32_t>(byte * 8 + reader.BitPosition());
+                }
+
+                positions[group] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanePositions));
+            }
+
+            step++;
+            continue;
+        }
+
+        /* Второй символ из того же слова: после сдвига на позицию % 8
+           и первого кода в нём остаётся 32 - 7 - LookupBits >= LookupBits
+           битов */
+        longCodes = (step + 1 == steps);
+
+        for (int group = 0; group < groupCount && longCodes == 0; group++)
+        {
+            secondEntries[group] = _mm256_i32gather_epi32(table, _mm256_srli_epi32(_mm256_sllv_epi32(words[group], lengths[group]), 32 - LookupBits), 4);
+            secondLengths[group] = _mm256_srli_epi32(secondEntries[group], 8);
+            longCodes |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(secondLengths[group], zero)));
+        }
+
+        for (int group = 0; group < groupCount; group++)
+        {
+            char* groupOutput = output + step * laneCount + group * GroupLanes;
+            positions[group] = _mm256_add_epi32(positions[group], lengths[group]);
+            __m256i symbols = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(entries[group], packSymbols), joinHalves);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(groupOutput), _mm256_castsi256_si128(symbols));
+
+            if (longCodes == 0)
+            {
+                positions[group] = _mm256_add_epi32(positions[group], secondLengths[group]);
+                symbols = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(secondEntries[group], packSymbols), joinHalves);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(groupOutput + laneCount), _mm256_castsi256_si128(symbols));
+            }
+        }
+
+        step += (longCodes == 0) ? 2 : 1;
+    }
+
+    for (int group = 0; group < groupCount; group++)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanePositions), positions[group]);
+
+        for (int lane = 0; lane < GroupLanes; lane++)
+        {
+            bitPositions[group * GroupLanes + lane] = static_cast<size_t>(lanePositions[lane]);
+        }
+    }
+
+    return HuffmanTree::DecodeSuccess;
+}
+#else
+HuffmanTree::DecodeStatus HuffmanDecodeTable::DecodeLanesAvx2(const uint8_t* data, const std::vector<size_t>& laneEnds, size_t steps, char* output, std::vector<size_t>& bitPositions, size_t& step) const
+{
+    return HuffmanTree::DecodeSuccess;
+}
+#endif
+
+std::string HuffmanDecodeTable::DecodeSingle(const std::vector<uint8_t>& data, size_t symbolCount) const
+{
+    std::string decodedText(symbolCount, '\0');
+    BitReader reader(data.data(), data.size());
+
+    for (size_t position = 0; position < symbolCount; position++)
+    {
+        reader.Refill();
+        const Entry& entry = m_entries[reader.PeekBits(LookupBits)];
+
+        if (entry.m_count == 0)
+        {
+            if (!DecodeLongSymbol(reader, decodedText[position]))
+            {
+                decodedText.resize(position);
+                break;
+            }
+
+            continue;
+        }
+
+        decodedText[position] = static_cast<char>(entry.m_symbols[0]);
+        reader.ConsumeBits(entry.m_firstBits);
+    }
+
+    return decodedText;
+}
+
+/* Обход копии дерева бит за битом. Переход к отсутствующему потомку
+   означает неверный код */
+bool HuffmanDecodeTable::DecodeLongSymbol(BitReader& reader, char& symbol) const
+{
+    int node = 0;
+
+    if (m_tree.empty())
+    {
+        return false;
+    }
+
+    while (m_tree[node].m_left >= 0 || m_tree[node].m_right >= 0)
+    {
+        if (reader.BitsAvailable() == 0)
+        {
+            reader.Refill();
+        }
+
+        node = reader.ReadBits(1) ? m_tree[node].m_right : m_tree[node].m_left;
+
+        if (node < 0)
+        {
+            return false;
+        }
+    }
+
+    symbol = static_cast<char>(m_tree[node].m_symbol);
+
+    return true;
+}
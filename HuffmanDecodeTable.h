@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "HuffmanTree.h"
+
+/* Табличный декодер Хаффмана.
+   Следующие LookupBits битов потока - индекс в таблице. Запись хранит до
+   MaxSymbolsPerEntry символов, коды которых целиком помещаются в эти биты,
+   и их суммарную длину, так что на частых коротких кодах один поиск выдаёт
+   несколько байтов. Коды длиннее LookupBits декодируются обходом копии
+   дерева, хранящейся в таблице, так что исходное дерево можно удалить.
+   Индексы, с которых не начинается ни один код, тоже ведут в обход дерева,
+   поэтому неверные коды обнаруживаются вне основного цикла.
+   После построения таблица не меняется и может использоваться из многих
+   потоков одновременно. Основной цикл есть в двух вариантах - переносимом
+   и с инструкциями BMI2 (DecodeBmi2); вариант выбирается по CpuFeatures.
+
+   DecodeInterleaved декодирует символы, разнесённые по нескольким потокам
+   (символ i - в потоке i % числа потоков, потоки лежат подряд). Потоки
+   независимы, поэтому цикл AVX2 (DecodeLanesAvx2) продвигает по 8 потоков
+   одной командой: gather читает слово каждого потока и записи таблицы,
+   и за шаг выдаётся по символу из каждого потока. Без AVX2 потоки
+   декодируются по очереди переносимым циклом. */
+class HuffmanDecodeTable
+{
+public:
+    static const int LookupBits = 12;
+    static const int MaxSymbolsPerEntry = 4;
+    static const int MaxLanes = 16;
+
+    explicit HuffmanDecodeTable(const HuffmanTree& tree);                                               // Построение таблицы по дереву
+
+    std::string Decode(const std::vector<uint8_t>& data, size_t symbolCount) const;                     // Декодирование, несколько символов за поиск
+
+    std::string Decode(const uint8_t* data, size_t size, size_t symbolCount) const;
+
+    HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const;
+
+    HuffmanTree::DecodeStatus Decode(CpuFeatures::Isa isa, const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const;
+
+    HuffmanTree::DecodeStatus Decode(BitReader& reader, size_t symbolCount, char* output) const;        // Продолжение с текущего бита reader
+
+    HuffmanTree::DecodeStatus DecodeInterleaved(const uint8_t* data, const std::vector<size_t>& laneSizes, size_t symbolCount, std::string& decodedText) const;
+
+    HuffmanTree::DecodeStatus DecodeInterleaved(CpuFeatures::Isa isa, const uint8_t* data, const std::vector<size_t>& laneSizes, size_t symbolCount, std::string& decodedText) const;
+
+    std::string DecodeSingle(const std::vector<uint8_t>& data, size_t symbolCount) const;               // Декодирование, один символ за поиск
+
+private:
+    struct Entry
+    {
+        uint8_t m_symbols[MaxSymbolsPerEntry];
+        uint8_t m_count;                                                                                // 0 - первый код длиннее LookupBits
+        uint8_t m_bits;                                                                                 // Длина всех кодов записи
+        uint8_t m_firstBits;                                                                            // Длина кода первого символа
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_laneEntries;                                                                // Символ и длина первого кода << 8 (0 - обход дерева)
+    std::vector<HuffmanTree::FlatNode> m_tree;
+    int m_minLength = 0;                                                                                // Длина самого короткого кода (0 - кодов нет)
+
+    bool DecodeLongSymbol(BitReader& reader, char& symbol) const;                                       // Обход дерева для длинных и неверных кодов
+
+    HuffmanTree::DecodeStatus DecodeFrom(BitReader& reader, size_t position, size_t symbolCount, char* output) const;
+
+    HuffmanTree::DecodeStatus DecodeBmi2(const uint8_t* data, size_t size, size_t symbolCount, char* output) const;
+
+    HuffmanTree::DecodeStatus DecodeLanesAvx2(const uint8_t* data, const std::vector<size_t>& laneEnds, size_t steps, char* output, std::vector<size_t>& bitPositions, size_t& step) const;
+};
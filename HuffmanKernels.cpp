@@ -0,0 +1,200 @@
+#include "HuffmanKernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/* Гистограмма в четыре частичные таблицы: одинаковые соседние байты
+   попадают в разные счётчики, и инкременты не ждут друг друга через
+   память. 32-битные счётчики сбрасываются в общие 64-битные каждые 2^30
+   байт, поэтому не переполняются */
+static void CountBytesKernel(const uint8_t* bytes, size_t size, uint64_t* frequencies)
+{
+    uint32_t counts[4][256];
+
+    while (size > 0)
+    {
+        size_t chunk = std::min<size_t>(size, size_t(1) << 30);
+        size_t position = 0;
+        std::memset(counts, 0, sizeof(counts));
+
+        for (; position + 8 <= chunk; position += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + position, sizeof(word));
+
+            counts[0][word & 0xFF]++;
+            counts[1][(word >> 8) & 0xFF]++;
+            counts[2][(word >> 16) & 0xFF]++;
+            counts[3][(word >> 24) & 0xFF]++;
+            counts[0][(word >> 32) & 0xFF]++;
+            counts[1][(word >> 40) & 0xFF]++;
+            counts[2][(word >> 48) & 0xFF]++;
+            counts[3][word >> 56]++;
+        }
+
+        for (; position < chunk; position++)
+        {
+            counts[0][bytes[position]]++;
+        }
+
+        for (int symbol = 0; symbol < 256; symbol++)
+        {
+            frequencies[symbol] += static_cast<uint64_t>(counts[0][symbol]) + counts[1][symbol] + counts[2][symbol] + counts[3][symbol];
+        }
+
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+__attribute__((always_inline)) static inline void EncodeBytesKernel(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, BitWriter& writer)
+{
+    for (size_t position = 0; position < size; position++)
+    {
+        const HuffmanTree::Code& code = codes[bytes[position]];
+        writer.WriteBits(code.m_bits, code.m_length);
+    }
+}
+
+using EncodeFunction = void (*)(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer);
+
+static void EncodeBytesScalar(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, size_t /*codeCount*/, BitWriter& writer)
+{
+    EncodeBytesKernel(bytes, size, codes, writer);
+}
+
+#if defined(__x86_64__)
+/* Упаковка AVX2 по 8 символов. Коды и длины собираются из таблицы
+   инструкцией gather (Code - 16 байт: биты по индексу 2 * символ, длина
+   по индексу 2 * символ + 1 в 8-байтовых единицах), затем соседние коды
+   сливаются попарно сдвигами на переменную величину (_mm256_sllv_epi64):
+   длины пар - частичные суммы длин, и пара - это её коды, уже стоящие на
+   своих битовых позициях. Если коды не длиннее 14 битов, четвёрка
+   помещается в BitWriter::MaxWriteBits, и 8 символов записываются двумя
+   вызовами WriteBits; до 28 битов - четырьмя парами; длиннее - по одному.
+   Таблица может быть короче 256 кодов (алфавит дерева меньше байтового),
+   поэтому наибольшая длина ищется только среди codeCount кодов */
+__attribute__((target("avx2"), always_inline)) static inline void EncodeBytesGather(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer)
+{
+    int maxLength = 0;
+
+    for (size_t symbol = 0; symbol < std::min<size_t>(codeCount, 256); symbol++)
+    {
+        maxLength = std::max(maxLength, codes[symbol].m_length);
+    }
+
+    if (maxLength > 2 * 14)
+    {
+        EncodeBytesKernel(bytes, size, codes, writer);
+
+        return;
+    }
+
+    const long long* table = reinterpret_cast<const long long*>(codes);
+    const __m256i lengthMask = _mm256_set1_epi64x(0xFF);
+    bool quads = (maxLength <= 14);
+    size_t position = 0;
+
+    for (; position + 8 <= size; position += 8)
+    {
+        uint64_t eight;
+        std::memcpy(&eight, bytes + position, sizeof(eight));
+        __m256i indices = _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(eight))), 1);
+        __m128i lowIndices = _mm256_castsi256_si128(indices);
+        __m128i highIndices = _mm256_extracti128_si256(indices, 1);
+        __m128i one = _mm_set1_epi32(1);
+
+        __m256i bits[2] = { _mm256_i32gather_epi64(table, lowIndices, 8), _mm256_i32gather_epi64(table, highIndices, 8) };
+        __m256i lengths[2] = { _mm256_and_si256(_mm256_i32gather_epi64(table, _mm_add_epi32(lowIndices, one), 8), lengthMask),
+            _mm256_and_si256(_mm256_i32gather_epi64(table, _mm_add_epi32(highIndices, one), 8), lengthMask) };
+
+        for (int half = 0; half < 2; half++)
+        {
+            /* Лучи 0 и 2: (код 0 << длина 1) | код 1 и то же для 2 и 3 */
+            __m256i nextLengths = _mm256_unpackhi_epi64(lengths[half], lengths[half]);
+            __m256i pairs = _mm256_or_si256(_mm256_sllv_epi64(bits[half], nextLengths), _mm256_unpackhi_epi64(bits[half], bits[half]));
+            __m256i pairLengths = _mm256_add_epi64(lengths[half], nextLengths);
+
+            uint64_t firstPair = static_cast<uint64_t>(_mm256_extract_epi64(pairs, 0));
+            uint64_t secondPair = static_cast<uint64_t>(_mm256_extract_epi64(pairs, 2));
+            int firstLength = static_cast<int>(_mm256_extract_epi64(pairLengths, 0));
+            int secondLength = static_cast<int>(_mm256_extract_epi64(pairLengths, 2));
+
+            if (quads)
+            {
+                writer.WriteBits((firstPair << secondLength) | secondPair, firstLength + secondLength);
+            }
+            else
+            {
+                writer.WriteBits(firstPair, firstLength);
+                writer.WriteBits(secondPair, secondLength);
+            }
+        }
+    }
+
+    EncodeBytesKernel(bytes + position, size - position, codes, writer);
+}
+
+__attribute__((target("avx2")))
+static void EncodeBytesAvx2(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer)
+{
+    EncodeBytesGather(bytes, size, codes, codeCount, writer);
+}
+
+__attribute__((target("avx2,bmi,bmi2")))
+static void EncodeBytesBmi2(const uint8_t* bytes, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer)
+{
+    EncodeBytesGather(bytes, size, codes, codeCount, writer);
+}
+#endif
+
+/* Реализация для уровня isa; уровень выше доступного понижается.
+   Упаковке кодов помогают gather AVX2 и сдвиги BMI2 */
+static EncodeFunction SelectEncode(CpuFeatures::Isa isa)
+{
+#if defined(__x86_64__)
+    switch (std::min(isa, CpuFeatures::Best()))
+    {
+    case CpuFeatures::Bmi2:
+        return EncodeBytesBmi2;
+    case CpuFeatures::Avx2:
+        return EncodeBytesAvx2;
+    default:
+        break;
+    }
+#endif
+
+    return EncodeBytesScalar;
+}
+
+/* Гистограмма одна для всех наборов инструкций: пересборка с target
+   SSE4.2/AVX2 не быстрее (четыре таблицы упираются в загрузки и
+   инкременты в памяти, а не в вычисления), поэтому выбора нет */
+void HuffmanKernels::CountBytes(const void* data, size_t size, uint64_t* frequencies)
+{
+    CountBytesKernel(static_cast<const uint8_t*>(data), size, frequencies);
+}
+
+std::vector<uint64_t> HuffmanKernels::CountBytes(const std::string& text)
+{
+    std::vector<uint64_t> frequencies(256, 0);
+    CountBytes(text.data(), text.size(), frequencies.data());
+
+    return frequencies;
+}
+
+void HuffmanKernels::EncodeBytes(const void* data, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer)
+{
+    static const EncodeFunction encode = SelectEncode(CpuFeatures::Best());
+
+    encode(static_cast<const uint8_t*>(data), size, codes, codeCount, writer);
+}
+
+void HuffmanKernels::EncodeBytes(CpuFeatures::Isa isa, const void* data, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer)
+{
+    SelectEncode(isa)(static_cast<const uint8_t*>(data), size, codes, codeCount, writer);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "CpuFeatures.h"
+#include "HuffmanTree.h"
+
+/* Вычислительные ядра кодера: гистограмма байтов и упаковка кодов.
+   У упаковки несколько реализаций под разные наборы инструкций
+   (__attribute__((target))): gather AVX2 и сдвиги BMI2 (shlx/shrx
+   в BitWriter), а программа собирается без -march и запускается на любом
+   x86-64. Реализация выбирается один раз по CpuFeatures::Best();
+   перегрузка с явным уровнем нужна, чтобы сравнивать реализации.
+   Гистограмма одна: сборка под другие наборы её не ускоряет. */
+class HuffmanKernels
+{
+public:
+    static void CountBytes(const void* data, size_t size, uint64_t* frequencies);                       // Прибавление гистограммы к frequencies[256]
+
+    static std::vector<uint64_t> CountBytes(const std::string& text);                                   // Гистограмма текста
+
+    static void EncodeBytes(const void* data, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer);
+
+    static void EncodeBytes(CpuFeatures::Isa isa, const void* data, size_t size, const HuffmanTree::Code* codes, size_t codeCount, BitWriter& writer);
+};
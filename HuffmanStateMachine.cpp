@@ -0,0 +1,186 @@
+#include "HuffmanStateMachine.h"
+
+#include <cstring>
+
+/* Построение: состояния нумеруются по внутренним узлам копии дерева,
+   затем для каждого состояния и байта проходятся 8 битов байта */
+HuffmanStateMachine::HuffmanStateMachine(const HuffmanTree& tree)
+    : m_tree(tree.BuildFlatTree()), m_nodeStates(m_tree.size(), -1)
+{
+    std::vector<int> depths(m_tree.size(), 0);
+
+    /* Копия дерева записана в прямом порядке: родитель раньше потомков */
+    for (size_t node = 0; node < m_tree.size(); node++)
+    {
+        const HuffmanTree::FlatNode& flatNode = m_tree[node];
+
+        if (flatNode.m_left < 0 && flatNode.m_right < 0)
+        {
+            if (depths[node] > 0 && (m_minLength == 0 || depths[node] < m_minLength))
+            {
+                m_minLength = depths[node];
+            }
+
+            continue;
+        }
+
+        m_nodeStates[node] = static_cast<int>(m_stateNodes.size());
+        m_stateNodes.push_back(static_cast<int>(node));
+
+        for (int child : { flatNode.m_left, flatNode.m_right })
+        {
+            if (child >= 0)
+            {
+                depths[child] = depths[node] + 1;
+            }
+        }
+    }
+
+    if (m_stateNodes.empty() || m_stateNodes.size() > MaxStates)
+    {
+        return;
+    }
+
+    m_transitions.resize(m_stateNodes.size() * 256);
+
+    for (size_t state = 0; state < m_stateNodes.size(); state++)
+    {
+        for (int byte = 0; byte < 256; byte++)
+        {
+            Transition& transition = m_transitions[state * 256 + byte];
+            transition = Transition{ { 0, 0, 0, 0, 0, 0, 0, 0 }, 0, 0 };
+            int node = m_stateNodes[state];
+
+            for (int bit = 7; bit >= 0; bit--)
+            {
+                node = ((byte >> bit) & 1) ? m_tree[node].m_right : m_tree[node].m_left;
+
+                if (node < 0)
+                {
+                    transition.m_count = InvalidTransition;
+                    break;
+                }
+
+                if (m_nodeStates[node] < 0)
+                {
+                    transition.m_symbols[transition.m_count++] = static_cast<uint8_t>(m_tree[node].m_symbol);
+                    node = 0;
+                }
+            }
+
+            if (transition.m_count != InvalidTransition)
+            {
+                transition.m_next = static_cast<uint32_t>(m_nodeStates[node]) * 256;
+            }
+        }
+    }
+}
+
+std::string HuffmanStateMachine::Decode(const std::vector<uint8_t>& data, size_t symbolCount) const
+{
+    std::string decodedText;
+    Decode(data.data(), data.size(), symbolCount, decodedText);
+
+    return decodedText;
+}
+
+/* Декодирование. Переход копируется целиком (8 байт), поэтому у результата
+   есть запас в MaxSymbolsPerByte байт; символы из дополнения последнего
+   байта отбрасываются. Число символов ограничивается до выделения памяти,
+   как у HuffmanDecodeTable. При ошибке результат пуст */
+HuffmanTree::DecodeStatus HuffmanStateMachine::Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    if (symbolCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (m_minLength == 0)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    if (symbolCount > size * 8 / m_minLength)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    decodedText.resize(symbolCount + MaxSymbolsPerByte);
+    char* output = &decodedText[0];
+    const Transition* transitions = m_transitions.empty() ? nullptr : m_transitions.data();
+    size_t position = 0;
+    uint32_t row = 0;
+
+    for (size_t byte = 0; byte < size && position < symbolCount; byte++)
+    {
+        if (transitions != nullptr)
+        {
+            const Transition& transition = transitions[row + data[byte]];
+
+            if (transition.m_count != InvalidTransition)
+            {
+                std::memcpy(output + position, transition.m_symbols, MaxSymbolsPerByte);
+                position += transition.m_count;
+                row = transition.m_next;
+                continue;
+            }
+        }
+
+        int state = static_cast<int>(row / 256);
+
+        if (!DecodeByte(state, data[byte], output, position, symbolCount))
+        {
+            decodedText.clear();
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        row = static_cast<uint32_t>(state) * 256;
+    }
+
+    if (position < symbolCount)
+    {
+        decodedText.clear();
+
+        return HuffmanTree::TruncatedStream;
+    }
+
+    decodedText.resize(symbolCount);
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+size_t HuffmanStateMachine::StateCount() const
+{
+    return m_stateNodes.size();
+}
+
+/* Разбор байта по битам с узла состояния state. Путь без символа -
+   неверный код, но только если он встретился раньше symbolCount символов:
+   дополнение последнего байта не проверяется */
+bool HuffmanStateMachine::DecodeByte(int& state, uint8_t byte, char* output, size_t& position, size_t symbolCount) const
+{
+    int node = m_stateNodes[state];
+
+    for (int bit = 7; bit >= 0 && position < symbolCount; bit--)
+    {
+        node = ((byte >> bit) & 1) ? m_tree[node].m_right : m_tree[node].m_left;
+
+        if (node < 0)
+        {
+            return false;
+        }
+
+        if (m_nodeStates[node] < 0)
+        {
+            output[position++] = static_cast<char>(m_tree[node].m_symbol);
+            node = 0;
+        }
+    }
+
+    state = m_nodeStates[node];
+
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "HuffmanTree.h"
+
+/* Декодер-автомат: один байт данных за шаг.
+   Состояние - внутренний узел дерева, на котором остановился разбор
+   (0 - корень). Для каждой пары (состояние, байт) заранее пройдены все
+   8 битов байта: переход хранит символы, завершившиеся внутри байта
+   (до MaxSymbolsPerByte), и следующее состояние. Декодирование - поиск
+   в таблице и копирование 8 байт на каждый байт данных, без накопителя
+   битов и сдвигов, поэтому подходит машинам без BMI2 и быстрых сдвигов.
+   Таблица занимает 4 КБ на внутренний узел (до 1 МБ на 256 символов),
+   так что выгодна на небольших алфавитах.
+   Переходы, на которых встречается путь без символа (неполный код),
+   и деревья больше MaxStates внутренних узлов разбираются обходом
+   копии дерева бит за битом. */
+class HuffmanStateMachine
+{
+public:
+    static const int MaxSymbolsPerByte = 8;
+    static const int MaxStates = 256;
+
+    explicit HuffmanStateMachine(const HuffmanTree& tree);                                              // Построение таблицы переходов по дереву
+
+    std::string Decode(const std::vector<uint8_t>& data, size_t symbolCount) const;                     // Декодирование упакованных битов
+
+    HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const;
+
+    size_t StateCount() const;                                                                          // Число состояний (внутренних узлов)
+
+private:
+    static const uint8_t InvalidTransition = 0xFF;
+
+    struct Transition
+    {
+        uint8_t m_symbols[MaxSymbolsPerByte];
+        uint32_t m_next;                                                                                // Начало строки следующего состояния
+        uint8_t m_count;                                                                                // InvalidTransition - разбор по битам
+    };
+
+    std::vector<Transition> m_transitions;                                                              // Строки по 256 переходов на состояние
+    std::vector<HuffmanTree::FlatNode> m_tree;
+    std::vector<int> m_stateNodes;                                                                      // Узел дерева каждого состояния
+    std::vector<int> m_nodeStates;                                                                      // Состояние внутреннего узла, -1 - лист
+    int m_minLength = 0;                                                                                // Длина самого короткого кода (0 - кодов нет)
+
+    bool DecodeByte(int& state, uint8_t byte, char* output, size_t& position, size_t symbolCount) const;
+};
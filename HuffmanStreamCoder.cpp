@@ -0,0 +1,283 @@
+#include "HuffmanStreamCoder.h"
+
+#include <algorithm>
+#include <string>
+
+#include "BitStream.h"
+#include "Crc32c.h"
+#include "HuffmanBlock.h"
+#include "HuffmanDecodeTable.h"
+#include "HuffmanKernels.h"
+#include "HuffmanTree.h"
+
+/* Конструктор */
+HuffmanStreamCoder::HuffmanStreamCoder(size_t segmentSize, size_t sampleBlockSize)
+    : m_segmentSize(std::min(std::max<size_t>(segmentSize, 1), static_cast<size_t>(MaxSegmentBytes))), m_sampleBlockSize(sampleBlockSize)
+{
+}
+
+/* Сжатие в два прохода: гистограмма (точная или по выборке), затем возврат
+   к началу входа и кодирование отрезками. Если вход изменился между
+   проходами, сжатие завершается ошибкой */
+bool HuffmanStreamCoder::Compress(std::istream& input, std::ostream& output) const
+{
+    std::streampos start = input.tellg();
+
+    if (start == std::streampos(-1))
+    {
+        return false;
+    }
+
+    uint64_t total = 0;
+    std::vector<uint64_t> frequencies;
+
+    if (m_sampleBlockSize > 0)
+    {
+        input.seekg(0, std::ios::end);
+        total = static_cast<uint64_t>(input.tellg() - start);
+        input.seekg(start);
+        frequencies = SampleFrequencies(input, total, m_sampleBlockSize);
+    }
+    else
+    {
+        frequencies = CountFrequencies(input, m_segmentSize, total);
+    }
+
+    if (input.bad())
+    {
+        return false;
+    }
+
+    input.clear();
+    input.seekg(start);
+
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(HuffmanTree::ScaleFrequencies(frequencies, MaxScaledTotal));
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+
+    HuffmanTree canonicalTree;
+    canonicalTree.BuildFromCodeLengths(codeLengths);
+    std::vector<HuffmanTree::Code> codeTable = canonicalTree.BuildPackedCodeTable();
+
+    std::vector<uint8_t> header;
+    HuffmanBlock::WriteVarint(total, header);
+    HuffmanBlock::WriteVarint(m_segmentSize, header);
+    HuffmanBlock::WriteVarint(std::count_if(codeLengths.begin(), codeLengths.end(), [](int length) { return length > 0; }), header);
+
+    for (size_t symbol = 0; symbol < codeLengths.size(); symbol++)
+    {
+        if (codeLengths[symbol] > 0)
+        {
+            header.push_back(static_cast<uint8_t>(symbol));
+            header.push_back(static_cast<uint8_t>(codeLengths[symbol]));
+        }
+    }
+
+    output.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+    std::string buffer(m_segmentSize, '\0');
+    uint32_t crc = 0;
+
+    for (uint64_t remaining = total; remaining > 0 && output; )
+    {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(m_segmentSize, remaining));
+        input.read(&buffer[0], static_cast<std::streamsize>(size));
+
+        if (static_cast<size_t>(input.gcount()) != size)
+        {
+            return false;
+        }
+
+        crc = Crc32c::Calculate(buffer.data(), size, crc);
+        BitWriter writer(size);
+        HuffmanKernels::EncodeBytes(buffer.data(), size, codeTable.data(), codeTable.size(), writer);
+
+        std::vector<uint8_t> payload = writer.Finish();
+        std::vector<uint8_t> length;
+        HuffmanBlock::WriteVarint(payload.size(), length);
+
+        output.write(reinterpret_cast<const char*>(length.data()), static_cast<std::streamsize>(length.size()));
+        output.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        remaining -= size;
+    }
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        output.put(static_cast<char>(crc >> shift));
+    }
+
+    return static_cast<bool>(output);
+}
+
+/* Распаковка по отрезкам. Размеры из заголовка проверяются до выделения
+   памяти. Отрезки выводятся по мере декодирования, поэтому несовпадение
+   CRC32C обнаруживается только в конце, когда текст уже записан */
+bool HuffmanStreamCoder::Decompress(std::istream& input, std::ostream& output) const
+{
+    uint64_t total = 0;
+    uint64_t segmentSize = 0;
+    uint64_t usedSymbols = 0;
+
+    if (!ReadVarint(input, total) || !ReadVarint(input, segmentSize) || !ReadVarint(input, usedSymbols))
+    {
+        return false;
+    }
+
+    if (segmentSize == 0 || segmentSize > MaxSegmentBytes || usedSymbols > 256)
+    {
+        return false;
+    }
+
+    std::vector<int> codeLengths(256, 0);
+
+    for (uint64_t used = 0; used < usedSymbols; used++)
+    {
+        int symbol = input.get();
+        int length = input.get();
+
+        if (length == std::char_traits<char>::eof() || length == 0 || length > BitWriter::MaxWriteBits || codeLengths[symbol] != 0)
+        {
+            return false;
+        }
+
+        codeLengths[symbol] = length;
+    }
+
+    HuffmanTree tree;
+
+    if (total > 0 && (!HuffmanTree::CheckKraft(codeLengths, true) || !tree.BuildFromCodeLengths(codeLengths)))
+    {
+        return false;
+    }
+
+    HuffmanDecodeTable decodeTable(tree);
+    std::vector<uint8_t> payload;
+    std::string text;
+    uint32_t crc = 0;
+
+    for (uint64_t remaining = total; remaining > 0; )
+    {
+        size_t size = static_cast<size_t>(std::min(segmentSize, remaining));
+        uint64_t payloadBytes = 0;
+
+        if (!ReadVarint(input, payloadBytes) || payloadBytes > static_cast<uint64_t>(size) * BitWriter::MaxWriteBits / 8 + 1)
+        {
+            return false;
+        }
+
+        payload.resize(static_cast<size_t>(payloadBytes));
+        input.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payloadBytes));
+
+        if (static_cast<uint64_t>(input.gcount()) != payloadBytes)
+        {
+            return false;
+        }
+
+        if (decodeTable.Decode(payload.data(), payload.size(), size, text) != HuffmanTree::DecodeSuccess)
+        {
+            return false;
+        }
+
+        crc = Crc32c::Calculate(text.data(), text.size(), crc);
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+        remaining -= size;
+
+        if (!output)
+        {
+            return false;
+        }
+    }
+
+    uint32_t expected = 0;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int byte = input.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+
+        expected |= static_cast<uint32_t>(byte) << shift;
+    }
+
+    return crc == expected;
+}
+
+/* Гистограмма потока до конца буферами по bufferSize байт. Счётчики
+   64-битные, поэтому не переполняются ни на каком реальном входе */
+std::vector<uint64_t> HuffmanStreamCoder::CountFrequencies(std::istream& input, size_t bufferSize, uint64_t& total)
+{
+    std::vector<uint64_t> frequencies(256, 0);
+    std::string buffer(std::max<size_t>(bufferSize, 1), '\0');
+    total = 0;
+
+    while (input)
+    {
+        input.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+        size_t size = static_cast<size_t>(input.gcount());
+        HuffmanKernels::CountBytes(buffer.data(), size, frequencies.data());
+        total += size;
+    }
+
+    return frequencies;
+}
+
+/* Гистограмма по выборке из size байт с текущей позиции: блоки по
+   blockSize байт с шагом SampleStride блоков. Небольшой вход считается
+   целиком. Частоты выборки не приводятся к размеру входа - дереву важны
+   только пропорции, а ScaleFrequencies при необходимости уменьшит их сам */
+std::vector<uint64_t> HuffmanStreamCoder::SampleFrequencies(std::istream& input, uint64_t size, size_t blockSize)
+{
+    std::vector<uint64_t> frequencies(256, 0);
+    std::streampos start = input.tellg();
+    uint64_t step = static_cast<uint64_t>(blockSize) * SampleStride;
+    std::string buffer(blockSize, '\0');
+
+    bool sampled = (size >= step * 4);
+
+    for (uint64_t offset = 0; offset < size && input; offset += sampled ? step : blockSize)
+    {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(blockSize, size - offset));
+        input.seekg(start + static_cast<std::streamoff>(offset));
+        input.read(&buffer[0], static_cast<std::streamsize>(count));
+        HuffmanKernels::CountBytes(buffer.data(), static_cast<size_t>(input.gcount()), frequencies.data());
+    }
+
+    /* Escape для байтов вне выборки */
+    for (uint64_t& frequency : frequencies)
+    {
+        if (sampled && frequency == 0)
+        {
+            frequency = 1;
+        }
+    }
+
+    return frequencies;
+}
+
+/* varint из потока: 7 битов на байт, младшие первыми */
+bool HuffmanStreamCoder::ReadVarint(std::istream& input, uint64_t& value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = input.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
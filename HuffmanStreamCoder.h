@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/* Сжатие потока любой длины одной таблицей кодов.
+   Первый проход считает 64-битную гистограмму всего входа, второй кодирует
+   его отрезками по segmentSize байт, поэтому память ограничена размером
+   отрезка, а не входа, и вход может быть в сотни гигабайт. Вход должен
+   допускать повторное чтение (файл). Если сумма частот больше
+   MaxScaledTotal, частоты масштабируются (HuffmanTree::ScaleFrequencies),
+   чтобы коды помещались в BitWriter::MaxWriteBits.
+
+   С sampleBlockSize > 0 первый проход читает не весь вход, а один блок
+   из каждых SampleStride (остальные пропускаются переходом по потоку),
+   так что до начала вывода читается 1/SampleStride входа. Байты, не
+   попавшие в выборку, получают частоту 1 - это escape: любой байт
+   остаётся кодируемым, ценой длинного кода для редких. На больших
+   файлах гистограмма выборки почти не отличается от точной.
+
+   Формат потока:
+
+       varint    длина входа в байтах
+       varint    размер отрезка в байтах
+       varint    число используемых символов n
+       n пар     (байт символа, байт длины кода)
+       отрезки   varint длины данных и упакованные биты; все отрезки,
+                 кроме последнего, кодируют ровно размер отрезка байт
+       4 байта   CRC32C всего входа, младший байт первым */
+class HuffmanStreamCoder
+{
+public:
+    static const uint64_t MaxScaledTotal = uint64_t(1) << 32;                                           // Сумма частот, при которой коды не длиннее 46 бит
+    static const size_t MaxSegmentBytes = size_t(1) << 30;                                              // Отрезок больше считается повреждённым
+
+    static const size_t SampleStride = 16;                                                              // Читается один блок из SampleStride
+
+    explicit HuffmanStreamCoder(size_t segmentSize = 1 << 20, size_t sampleBlockSize = 0);              // Конструктор (0 - точная гистограмма)
+
+    bool Compress(std::istream& input, std::ostream& output) const;                                     // Сжатие (false - ошибка ввода-вывода)
+
+    bool Decompress(std::istream& input, std::ostream& output) const;                                   // Распаковка (false - повреждённые данные)
+
+    static std::vector<uint64_t> CountFrequencies(std::istream& input, size_t bufferSize, uint64_t& total);
+
+    static std::vector<uint64_t> SampleFrequencies(std::istream& input, uint64_t size, size_t blockSize);
+
+private:
+    size_t m_segmentSize;
+    size_t m_sampleBlockSize;                                                                           // 0 - первый проход читает весь вход
+
+    static bool ReadVarint(std::istream& input, uint64_t& value);                                       // varint из потока (false - конец или ошибка)
+};
@@ -0,0 +1,645 @@
+#include "HuffmanTree.h"
+
+#include <algorithm>
+
+#include "HuffmanKernels.h"
+
+/* Конструктор */
+HuffmanTree::HuffmanTree()
+{
+    m_root = nullptr;
+}
+
+/* Перемещение: пул узлов переходит к новому владельцу, адреса узлов
+   не меняются */
+HuffmanTree::HuffmanTree(HuffmanTree&& other) noexcept
+    : m_root(other.m_root), m_alphabetSize(other.m_alphabetSize), m_nodes(std::move(other.m_nodes)), m_leafOrder(std::move(other.m_leafOrder)), m_frequencies(std::move(other.m_frequencies))
+{
+    other.m_root = nullptr;
+}
+
+/* Присваивание перемещением обменивает пулы: прежние узлы этого дерева
+   очищаются, но их память остаётся у other для его следующих построений */
+HuffmanTree& HuffmanTree::operator=(HuffmanTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_alphabetSize, other.m_alphabetSize);
+        m_nodes.swap(other.m_nodes);
+        m_leafOrder.swap(other.m_leafOrder);
+        m_frequencies.swap(other.m_frequencies);
+        other.Reset();
+    }
+
+    return *this;
+}
+
+/* Деструктор: узлы принадлежат пулу m_nodes */
+HuffmanTree::~HuffmanTree()
+{
+}
+
+/* Очистка дерева с сохранением памяти пула */
+void HuffmanTree::Reset()
+{
+    m_nodes.clear();
+    m_root = nullptr;
+}
+
+/* Новый узел из пула. Перед построением ёмкость пула резервируется под все
+   узлы дерева, поэтому вектор не перевыделяется и указатели остаются верными */
+HuffmanTree::Node* HuffmanTree::NewNode(int symbol, uint64_t frequency, Node* left, Node* right)
+{
+    m_nodes.emplace_back(symbol, frequency, left, right);
+
+    return &m_nodes.back();
+}
+
+/* Построение дерева Хаффмана */
+void HuffmanTree::BuildHuffmanTree(const std::string& text)
+{
+    m_frequencies.assign(256, 0);
+    HuffmanKernels::CountBytes(text.data(), text.size(), m_frequencies.data());
+
+    BuildHuffmanTree(m_frequencies);
+}
+
+void HuffmanTree::BuildHuffmanTree(const std::vector<uint64_t>& frequencies)
+{
+    Reset();
+    m_alphabetSize = frequencies.size();
+
+    /* Листья по возрастанию частоты, при равной частоте - по коду символа */
+    m_leafOrder.clear();
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if (frequencies[symbol] > 0)
+        {
+            m_leafOrder.emplace_back(frequencies[symbol], static_cast<int>(symbol));
+        }
+    }
+
+    if (m_leafOrder.empty())
+    {
+        return;
+    }
+
+    std::sort(m_leafOrder.begin(), m_leafOrder.end());
+    m_nodes.reserve(2 * m_leafOrder.size());
+
+    for (const auto& leaf : m_leafOrder)
+    {
+        NewNode(leaf.second, leaf.first);
+    }
+
+    /* Единственный символ получает код "0", а не пустой код */
+    if (m_nodes.size() == 1)
+    {
+        m_root = NewNode(0, m_nodes[0].m_frequency, &m_nodes[0]);
+
+        return;
+    }
+
+    /* Список, отсортированный по частоте, - это слияние двух очередей: листьев
+       и новых узлов, которые создаются с неубывающей частотой. При равной
+       частоте лист идёт раньше нового узла. Извлекаем два узла с наименьшей
+       частотой и добавляем их родителя в конец пула */
+    size_t leafCount = m_nodes.size();
+    size_t leafHead = 0;
+    size_t mergedHead = leafCount;
+
+    auto popSmallest = [&]()
+    {
+        if (leafHead < leafCount && (mergedHead == m_nodes.size() || m_nodes[leafHead].m_frequency <= m_nodes[mergedHead].m_frequency))
+        {
+            return &m_nodes[leafHead++];
+        }
+
+        return &m_nodes[mergedHead++];
+    };
+
+    while ((leafCount - leafHead) + (m_nodes.size() - mergedHead) > 1)
+    {
+        Node* node1 = popSmallest();
+        Node* node2 = popSmallest();
+
+        NewNode(0, node1->m_frequency + node2->m_frequency, node1, node2);
+    }
+
+    m_root = &m_nodes.back();
+}
+
+/* Обход дерева в прямом порядке с явным стеком вместо рекурсии, так что
+   глубина дерева не ограничена стеком вызовов. visit(node, depth, bit):
+   bit - 0 для левого потомка и корня, 1 для правого. Предки узла посещаются
+   раньше него, поэтому посетитель может хранить данные пути по глубине */
+template <typename Visit>
+void HuffmanTree::Traverse(Visit visit) const
+{
+    struct Step
+    {
+        Node* m_node;
+        int m_depth;
+        int m_bit;
+    };
+
+    std::vector<Step> stack;
+
+    if (m_root)
+    {
+        stack.push_back(Step{ m_root, 0, 0 });
+    }
+
+    while (!stack.empty())
+    {
+        Step step = stack.back();
+        stack.pop_back();
+
+        visit(step.m_node, step.m_depth, step.m_bit);
+
+        if (step.m_node->m_right)
+        {
+            stack.push_back(Step{ step.m_node->m_right, step.m_depth + 1, 1 });
+        }
+
+        if (step.m_node->m_left)
+        {
+            stack.push_back(Step{ step.m_node->m_left, step.m_depth + 1, 0 });
+        }
+    }
+}
+
+/* Таблица кодов всех символов */
+std::vector<std::string> HuffmanTree::BuildCodeTable() const
+{
+    std::vector<std::string> codeTable(m_alphabetSize);
+    std::string currentCode = "";
+
+    Traverse([&](Node* node, int depth, int bit)
+        {
+            if (depth > 0)
+            {
+                currentCode.resize(depth - 1);
+                currentCode += bit ? '1' : '0';
+            }
+
+            if (!node->m_left && !node->m_right)
+            {
+                codeTable[node->m_symbol] = currentCode;
+            }
+        });
+
+    return codeTable;
+}
+
+std::vector<HuffmanTree::Code> HuffmanTree::BuildPackedCodeTable() const
+{
+    std::vector<Code> codeTable(m_alphabetSize, Code{ 0, 0 });
+    std::vector<uint64_t> pathCodes;
+
+    Traverse([&](Node* node, int depth, int bit)
+        {
+            pathCodes.resize(depth + 1);
+            pathCodes[depth] = (depth > 0) ? (pathCodes[depth - 1] << 1) | bit : 0;
+
+            if (!node->m_left && !node->m_right)
+            {
+                codeTable[node->m_symbol] = Code{ pathCodes[depth], depth };
+            }
+        });
+
+    return codeTable;
+}
+
+/* Длины кодов всех символов */
+std::vector<int> HuffmanTree::BuildCodeLengths() const
+{
+    return CalculateStatistics().m_codeLengths;
+}
+
+/* Сведения о дереве за один проход: для каждого листа длина и код пути,
+   вес, а также число листьев на каждой глубине */
+HuffmanTree::Statistics HuffmanTree::CalculateStatistics() const
+{
+    Statistics statistics;
+    statistics.m_codeLengths.assign(m_alphabetSize, 0);
+    statistics.m_codes.assign(m_alphabetSize, Code{ 0, 0 });
+    statistics.m_weights.assign(m_alphabetSize, 0);
+    std::vector<uint64_t> pathCodes;
+
+    Traverse([&](Node* node, int depth, int bit)
+        {
+            pathCodes.resize(depth + 1);
+            pathCodes[depth] = (depth > 0) ? (pathCodes[depth - 1] << 1) | bit : 0;
+
+            if (node->m_left || node->m_right)
+            {
+                return;
+            }
+
+            statistics.m_codeLengths[node->m_symbol] = depth;
+            statistics.m_codes[node->m_symbol] = Code{ pathCodes[depth], depth };
+            statistics.m_weights[node->m_symbol] = node->m_frequency;
+
+            if (statistics.m_depthHistogram.size() <= static_cast<size_t>(depth))
+            {
+                statistics.m_depthHistogram.resize(depth + 1, 0);
+            }
+
+            statistics.m_depthHistogram[depth]++;
+        });
+
+    return statistics;
+}
+
+/* Пропорциональное уменьшение частот до суммы около maxTotal (ненулевые
+   частоты остаются не меньше 1, так что сумма может превысить maxTotal
+   на размер алфавита). Глубина дерева растёт не быстрее логарифма суммы
+   частот по основанию золотого сечения, поэтому сумма до 2^32 даёт коды
+   не длиннее 46 бит при любых исходных счётчиках. Относительная точность
+   частых символов почти не меняется, и длина кода на символ отличается
+   от построенной по точным счётчикам на ничтожную долю бита */
+std::vector<uint64_t> HuffmanTree::ScaleFrequencies(const std::vector<uint64_t>& frequencies, uint64_t maxTotal)
+{
+    uint64_t total = 0;
+
+    for (uint64_t frequency : frequencies)
+    {
+        total += frequency;
+    }
+
+    if (total <= maxTotal)
+    {
+        return frequencies;
+    }
+
+    std::vector<uint64_t> scaled(frequencies.size(), 0);
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if (frequencies[symbol] > 0)
+        {
+            uint64_t frequency = static_cast<uint64_t>(static_cast<unsigned __int128>(frequencies[symbol]) * maxTotal / total);
+            scaled[symbol] = std::max<uint64_t>(frequency, 1);
+        }
+    }
+
+    return scaled;
+}
+
+/* Неравенство Крафта: сумма 2^-length по используемым символам не больше 1,
+   иначе длины не образуют префиксный код. С requireComplete сумма должна
+   быть ровно 1, то есть в дереве нет путей без символа; исключение -
+   единственный символ с кодом длины 1, как его строит BuildHuffmanTree */
+bool HuffmanTree::CheckKraft(const std::vector<int>& codeLengths, bool requireComplete)
+{
+    int maxLength = 0;
+    size_t usedSymbols = 0;
+
+    for (int length : codeLengths)
+    {
+        if (length < 0 || length > MaxCodeLength)
+        {
+            return false;
+        }
+
+        maxLength = std::max(maxLength, length);
+        usedSymbols += (length > 0);
+    }
+
+    if (maxLength == 0)
+    {
+        return true;
+    }
+
+    /* Слагаемые не больше половины предела, поэтому проверка после каждого
+       сложения исключает переполнение */
+    uint64_t limit = uint64_t(1) << maxLength;
+    uint64_t kraftSum = 0;
+
+    for (int length : codeLengths)
+    {
+        if (length > 0)
+        {
+            kraftSum += uint64_t(1) << (maxLength - length);
+
+            if (kraftSum > limit)
+            {
+                return false;
+            }
+        }
+    }
+
+    if (requireComplete && kraftSum != limit)
+    {
+        return usedSymbols == 1 && maxLength == 1;
+    }
+
+    return true;
+}
+
+/* Дерево канонических кодов: символы упорядочены по длине кода, затем по
+   значению, и коды одной длины идут подряд. Возвращает false, если длины
+   не проходят CheckKraft и не могут образовать префиксный код */
+bool HuffmanTree::BuildFromCodeLengths(const std::vector<int>& codeLengths)
+{
+    Reset();
+    m_alphabetSize = codeLengths.size();
+
+    if (!CheckKraft(codeLengths))
+    {
+        return false;
+    }
+
+    int maxLength = 0;
+    size_t totalLength = 0;
+
+    for (int length : codeLengths)
+    {
+        maxLength = std::max(maxLength, length);
+        totalLength += length;
+    }
+
+    if (maxLength == 0)
+    {
+        return true;
+    }
+
+    std::vector<uint64_t> lengthCounts(maxLength + 1, 0);
+    std::vector<uint64_t> nextCodes(maxLength + 1, 0);
+
+    for (int length : codeLengths)
+    {
+        if (length > 0)
+        {
+            lengthCounts[length]++;
+        }
+    }
+
+    uint64_t code = 0;
+
+    for (int length = 1; length <= maxLength; length++)
+    {
+        code = (code + lengthCounts[length - 1]) << 1;
+        nextCodes[length] = code;
+    }
+
+    /* Путь каждого символа добавляет не больше length узлов */
+    m_nodes.reserve(1 + totalLength);
+    m_root = NewNode(0, 0);
+
+    for (size_t symbol = 0; symbol < codeLengths.size(); symbol++)
+    {
+        int length = codeLengths[symbol];
+
+        if (length == 0)
+        {
+            continue;
+        }
+
+        uint64_t symbolCode = nextCodes[length]++;
+        Node* currentNode = m_root;
+
+        for (int bit = length - 1; bit >= 0; bit--)
+        {
+            Node*& child = ((symbolCode >> bit) & 1) ? currentNode->m_right : currentNode->m_left;
+
+            if (!child)
+            {
+                child = NewNode(0, 0);
+            }
+
+            currentNode = child;
+        }
+
+        currentNode->m_symbol = static_cast<int>(symbol);
+    }
+
+    return true;
+}
+
+/* Дерево в виде массива: узел хранит индексы потомков */
+std::vector<HuffmanTree::FlatNode> HuffmanTree::BuildFlatTree() const
+{
+    std::vector<FlatNode> flatTree;
+    std::vector<int> pathIndices;
+    flatTree.reserve(m_nodes.size());
+
+    Traverse([&](Node* node, int depth, int bit)
+        {
+            int index = static_cast<int>(flatTree.size());
+            flatTree.push_back(FlatNode{ -1, -1, node->m_symbol });
+
+            if (depth > 0)
+            {
+                FlatNode& parent = flatTree[pathIndices[depth - 1]];
+                (bit ? parent.m_right : parent.m_left) = index;
+            }
+
+            pathIndices.resize(depth + 1);
+            pathIndices[depth] = index;
+        });
+
+    return flatTree;
+}
+
+/* Кодирование отдельного символа, текста */
+std::string HuffmanTree::Encode(char symbol) const
+{
+    std::string encodedSymbol = "";
+    std::string currentCode = "";
+    int searchSymbol = static_cast<unsigned char>(symbol);
+
+    Traverse([&](Node* node, int depth, int bit)
+        {
+            if (depth > 0)
+            {
+                currentCode.resize(depth - 1);
+                currentCode += bit ? '1' : '0';
+            }
+
+            if (!node->m_left && !node->m_right && node->m_symbol == searchSymbol)
+            {
+                encodedSymbol = currentCode;
+            }
+        });
+
+    return encodedSymbol;
+}
+
+std::pair<std::string, CompressionMetrics> HuffmanTree::Encode(const std::string& text) const
+{
+    std::string encodedText = "";
+
+    for (char huffmanChar : text)
+    {
+        encodedText += Encode(huffmanChar);
+    }
+
+    return std::make_pair(encodedText, CalculateMetrics(text));
+}
+
+/* Показатели сжатия: гистограмма текста и длины кодов дерева. Алфавит
+   дерева может быть меньше байтового - длины дополняются нулями до 256 */
+CompressionMetrics HuffmanTree::CalculateMetrics(const std::string& text) const
+{
+    std::vector<int> codeLengths = BuildCodeLengths();
+    codeLengths.resize(std::max<size_t>(codeLengths.size(), 256), 0);
+
+    return CompressionMetrics::Calculate(HuffmanKernels::CountBytes(text), codeLengths);
+}
+
+/* Декодирование текста */
+std::string HuffmanTree::Decode(const std::string& text) const
+{
+    std::string decodedText = "";
+    Decode(text, decodedText);
+
+    return decodedText;
+}
+
+/* Декодирование с проверкой: знак, отличный от '0' и '1', и переход
+   к отсутствующему потомку - неверный код, незавершённый код в конце -
+   обрезанные данные. При ошибке decodedText содержит символы до неё */
+HuffmanTree::DecodeStatus HuffmanTree::Decode(const std::string& text, std::string& decodedText) const
+{
+    decodedText.clear();
+    Node* currentNode = m_root;
+
+    if (!m_root)
+    {
+        return text.empty() ? DecodeSuccess : InvalidCode;
+    }
+
+    for (char huffmanChar : text)
+    {
+        if (huffmanChar != '0' && huffmanChar != '1')
+        {
+            return InvalidCode;
+        }
+
+        currentNode = (huffmanChar == '0') ? currentNode->m_left : currentNode->m_right;
+
+        if (!currentNode)
+        {
+            return InvalidCode;
+        }
+
+        if (!currentNode->m_left && !currentNode->m_right)
+        {
+            decodedText += static_cast<char>(currentNode->m_symbol);
+            currentNode = m_root;
+        }
+    }
+
+    return (currentNode == m_root) ? DecodeSuccess : TruncatedStream;
+}
+
+/* Кодирование текста в упакованные биты */
+std::pair<std::vector<uint8_t>, CompressionMetrics> HuffmanTree::EncodePacked(const std::string& text) const
+{
+    std::vector<Code> codeTable = BuildPackedCodeTable();
+    BitWriter writer(text.size() / 2);
+    HuffmanKernels::EncodeBytes(text.data(), text.size(), codeTable.data(), codeTable.size(), writer);
+
+    return std::make_pair(writer.Finish(), CalculateMetrics(text));
+}
+
+/* Декодирование упакованных битов обходом дерева. Длина потока задаётся
+   числом символов, поэтому нулевое дополнение последнего байта не читается */
+std::string HuffmanTree::DecodePacked(const std::vector<uint8_t>& data, size_t symbolCount) const
+{
+    std::string decodedText;
+    DecodePacked(data, symbolCount, decodedText);
+
+    return decodedText;
+}
+
+/* Код занимает хотя бы бит, поэтому число символов проверяется до выделения
+   памяти. Чтение за концом данных даёт нули и обнаруживается в конце */
+HuffmanTree::DecodeStatus HuffmanTree::DecodePacked(const std::vector<uint8_t>& data, size_t symbolCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    if (symbolCount > data.size() * 8)
+    {
+        return OutputOverrun;
+    }
+
+    decodedText.reserve(symbolCount);
+    BitReader reader(data.data(), data.size());
+
+    for (size_t position = 0; position < symbolCount; position++)
+    {
+        char symbol;
+
+        if (!DecodeSymbol(reader, symbol))
+        {
+            return InvalidCode;
+        }
+
+        decodedText += symbol;
+    }
+
+    return reader.IsOverrun() ? TruncatedStream : DecodeSuccess;
+}
+
+bool HuffmanTree::DecodeSymbol(BitReader& reader, char& symbol) const
+{
+    Node* currentNode = m_root;
+
+    if (!currentNode)
+    {
+        return false;
+    }
+
+    while (currentNode->m_left || currentNode->m_right)
+    {
+        if (reader.BitsAvailable() == 0)
+        {
+            reader.Refill();
+        }
+
+        currentNode = reader.ReadBits(1) ? currentNode->m_right : currentNode->m_left;
+
+        if (!currentNode)
+        {
+            return false;
+        }
+    }
+
+    symbol = static_cast<char>(currentNode->m_symbol);
+
+    return true;
+}
+
+/* Декодирование одного символа начиная с позиции position. Если код
+   не завершён до конца текста или ведёт к отсутствующему потомку, позиция
+   не меняется и возвращается false */
+bool HuffmanTree::DecodeSymbol(const std::string& text, size_t& position, char& symbol) const
+{
+    Node* currentNode = m_root;
+    size_t current = position;
+
+    while (currentNode && (currentNode->m_left || currentNode->m_right))
+    {
+        if (current == text.size())
+        {
+            return false;
+        }
+
+        currentNode = (text[current++] == '0') ? currentNode->m_left : currentNode->m_right;
+    }
+
+    if (!currentNode)
+    {
+        return false;
+    }
+
+    symbol = static_cast<char>(currentNode->m_symbol);
+    position = current;
+
+    return true;
+}
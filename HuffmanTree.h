@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "BitStream.h"
+#include "CompressionMetrics.h"
+
+/* Дерево Хаффмана. Построение (BuildHuffmanTree, BuildFromCodeLengths) меняет
+   дерево и требует единоличного доступа; константные методы можно вызывать
+   из нескольких потоков одновременно. Для общего использования потоками
+   дерево замораживается в FrozenHuffmanTable.
+   Узлы лежат в пуле внутри дерева: повторное построение тем же объектом
+   переиспользует память и после первого раза не обращается к аллокатору. */
+class HuffmanTree
+{
+public:
+    class Node;                                                                                         // Класс "Узел"
+
+    struct Code                                                                                         // Код символа, выровненный вправо
+    {
+        uint64_t m_bits;
+        int m_length;
+    };
+
+    struct FlatNode                                                                                     // Узел дерева в массиве (корень - индекс 0)
+    {
+        int m_left;                                                                                     // -1 - нет потомка
+        int m_right;
+        int m_symbol;                                                                                   // Символ листа
+    };
+
+    struct Statistics                                                                                   // Сведения о дереве, собранные за один обход
+    {
+        std::vector<int> m_codeLengths;                                                                 // 0 - символа нет
+        std::vector<Code> m_codes;
+        std::vector<uint64_t> m_weights;                                                                // Частоты листьев (0 для дерева по длинам кодов)
+        std::vector<int> m_depthHistogram;                                                              // Число листьев на каждой глубине
+    };
+
+    enum { MaxCodeLength = 63 };                                                                        // Код должен помещаться в Code::m_bits
+
+    enum DecodeStatus                                                                                   // Результат декодирования недоверенных данных
+    {
+        DecodeSuccess,
+        InvalidCode,                                                                                    // Путь без символа или знак не '0'/'1'
+        TruncatedStream,                                                                                // Данные кончились внутри кода
+        OutputOverrun                                                                                   // Символов больше, чем вмещают данные
+    };
+
+    HuffmanTree();                                                                                      // Конструктор
+
+    HuffmanTree(const HuffmanTree&) = delete;                                                           // Дерево только перемещается
+
+    HuffmanTree& operator=(const HuffmanTree&) = delete;
+
+    HuffmanTree(HuffmanTree&& other) noexcept;                                                          // Перемещение
+
+    HuffmanTree& operator=(HuffmanTree&& other) noexcept;
+
+    ~HuffmanTree();                                                                                     // Деструктор
+
+    void Reset();                                                                                       // Очистка дерева с сохранением памяти узлов
+
+    void BuildHuffmanTree(const std::string& text);                                                     // Построение дерева Хаффмана
+
+    void BuildHuffmanTree(const std::vector<uint64_t>& frequencies);                                    // Построение по таблице частот (индекс - символ, алфавит любого размера)
+
+    std::vector<std::string> BuildCodeTable() const;                                                    // Коды всех символов (пустая строка - символа нет)
+
+    std::vector<Code> BuildPackedCodeTable() const;                                                     // Коды всех символов в виде битов
+
+    std::vector<int> BuildCodeLengths() const;                                                          // Длины кодов всех символов (0 - символа нет)
+
+    bool BuildFromCodeLengths(const std::vector<int>& codeLengths);                                     // Дерево канонических кодов по длинам
+
+    Statistics CalculateStatistics() const;                                                             // Длины, коды, веса и гистограмма глубин
+
+    static bool CheckKraft(const std::vector<int>& codeLengths, bool requireComplete = false);
+
+    static std::vector<uint64_t> ScaleFrequencies(const std::vector<uint64_t>& frequencies, uint64_t maxTotal);
+
+    std::vector<FlatNode> BuildFlatTree() const;                                                        // Копия дерева в виде массива
+
+    std::string Encode(char symbol) const;                                                              // Кодирование отдельного символа
+
+    std::pair<std::string, CompressionMetrics> Encode(const std::string& text) const;                   // Кодирование текста
+
+    std::string Decode(const std::string& text) const;                                                  // Декодирование текста
+
+    DecodeStatus Decode(const std::string& text, std::string& decodedText) const;                       // Декодирование с проверкой кодов и конца данных
+
+    std::pair<std::vector<uint8_t>, CompressionMetrics> EncodePacked(const std::string& text) const;    // Кодирование текста в упакованные биты
+
+    std::string DecodePacked(const std::vector<uint8_t>& data, size_t symbolCount) const;               // Декодирование упакованных битов
+
+    DecodeStatus DecodePacked(const std::vector<uint8_t>& data, size_t symbolCount, std::string& decodedText) const;
+
+    bool DecodeSymbol(const std::string& text, size_t& position, char& symbol) const;                   // Декодирование одного символа с позиции
+
+    bool DecodeSymbol(BitReader& reader, char& symbol) const;                                           // Символ из упакованных битов (false - путь без символа)
+
+private:
+    Node* m_root = nullptr;
+    size_t m_alphabetSize = 256;                                                                        // Размер таблиц кодов (символы 0..m_alphabetSize-1)
+
+    std::vector<Node> m_nodes;                                                                          // Пул узлов, ёмкость сохраняется между построениями
+    std::vector<std::pair<uint64_t, int>> m_leafOrder;                                                  // Листья (частота, символ) для сортировки
+    std::vector<uint64_t> m_frequencies;                                                                // Гистограмма текста
+
+    Node* NewNode(int symbol, uint64_t frequency, Node* left = nullptr, Node* right = nullptr);         // Узел из пула
+
+    CompressionMetrics CalculateMetrics(const std::string& text) const;                                 // Показатели сжатия текста этим деревом
+
+    template <typename Visit>
+    void Traverse(Visit visit) const;                                                                   // Обход дерева без рекурсии
+};
+
+/* Класс "Узел" */
+class HuffmanTree::Node
+{
+public:
+    int m_symbol;
+    uint64_t m_frequency;
+    Node* m_left;
+    Node* m_right;
+
+    Node(int symbol, uint64_t frequency, Node* m_left = nullptr, Node* m_right = nullptr)
+        : m_symbol(symbol), m_frequency(frequency), m_left(m_left), m_right(m_right) {}
+
+};
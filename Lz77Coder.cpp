@@ -0,0 +1,499 @@
+#include "Lz77Coder.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const int HashBits = 16;
+
+/* Параметры уровней усилий 1..9, как в zlib: звеньев цепочки; длина,
+   после которой ленивый поиск просматривает четверть цепочки; длина,
+   до которой идёт ленивый поиск (0 - без него); достаточная длина */
+struct LevelParameters
+{
+    int m_maxChain;
+    int m_goodLength;
+    int m_lazyLength;
+    int m_niceLength;
+};
+
+static const LevelParameters Levels[] =
+{
+    { 4, 4, 0, 8 },
+    { 8, 4, 0, 16 },
+    { 32, 4, 0, 32 },
+    { 16, 4, 4, 16 },
+    { 32, 8, 16, 32 },
+    { 128, 8, 16, 128 },
+    { 256, 8, 32, 128 },
+    { 1024, 32, 128, 258 },
+    { 4096, 32, 258, 258 }
+};
+
+/* Номер старшего единичного бита */
+static int HighBit(uint32_t value)
+{
+    return 31 - __builtin_clz(value);
+}
+
+/* Код значения длины или расстояния и его дополнительные биты */
+static int ValueCode(uint32_t value, int& extraBits, uint32_t& extra)
+{
+    if (value < 4)
+    {
+        extraBits = 0;
+        extra = 0;
+
+        return static_cast<int>(value);
+    }
+
+    int highBit = HighBit(value);
+    extraBits = highBit - 1;
+    extra = value & ((uint32_t(1) << extraBits) - 1);
+
+    return 2 * highBit + static_cast<int>((value >> extraBits) & 1);
+}
+
+/* Наименьшее значение кода и число его дополнительных битов */
+static uint32_t CodeBase(int code, int& extraBits)
+{
+    if (code < 4)
+    {
+        extraBits = 0;
+
+        return static_cast<uint32_t>(code);
+    }
+
+    extraBits = (code >> 1) - 1;
+
+    return static_cast<uint32_t>(2 | (code & 1)) << extraBits;
+}
+
+/* Хеш первых MinMatch байт: умножение Фибоначчи, старшие HashBits битов */
+static uint32_t Hash(const uint8_t* data)
+{
+    uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+
+    return (value * 2654435761u) >> (32 - HashBits);
+}
+
+static uint16_t Load16(const uint8_t* data)
+{
+    uint16_t value;
+    std::memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+/* Длина общего начала двух строк, не больше maxLength: по 8 байт,
+   первое различие - по младшему отличающемуся биту */
+static int MatchLength(const uint8_t* first, const uint8_t* second, int maxLength)
+{
+    int length = 0;
+
+    while (length + 8 <= maxLength)
+    {
+        uint64_t firstWord;
+        uint64_t secondWord;
+        std::memcpy(&firstWord, first + length, sizeof(firstWord));
+        std::memcpy(&secondWord, second + length, sizeof(secondWord));
+
+        if (firstWord != secondWord)
+        {
+            return length + (__builtin_ctzll(firstWord ^ secondWord) >> 3);
+        }
+
+        length += 8;
+    }
+
+    while (length < maxLength && first[length] == second[length])
+    {
+        length++;
+    }
+
+    return length;
+}
+
+/* Конструктор */
+Lz77Coder::Lz77Coder(int windowBits, int level)
+    : m_windowBits(std::min(std::max(windowBits, static_cast<int>(MinWindowBits)), static_cast<int>(MaxWindowBits)))
+{
+    const LevelParameters& parameters = Levels[std::min(std::max(level, static_cast<int>(MinLevel)), static_cast<int>(MaxLevel)) - MinLevel];
+    m_maxChain = parameters.m_maxChain;
+    m_goodLength = parameters.m_goodLength;
+    m_lazyLength = parameters.m_lazyLength;
+    m_niceLength = parameters.m_niceLength;
+}
+
+/* Разбор. head хранит по хешу последнюю позицию + 1 (0 - позиций нет),
+   chain - предыдущую позицию с тем же хешем для каждой позиции окна.
+   Ячейка chain позиции перезаписывается только позицией на размер окна
+   дальше, поэтому звенья внутри окна всегда верны. При ленивом
+   сопоставлении совпадение короче m_lazyLength откладывается, пока со
+   следующей позиции находится более длинное: текущий байт тогда идёт
+   литералом. Для уже хорошего совпадения цепочка просматривается на
+   четверть - длиннее оно найдётся редко */
+std::vector<Lz77Coder::Token> Lz77Coder::Parse(const std::string& text) const
+{
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t size = text.size();
+    const size_t windowMask = (size_t(1) << m_windowBits) - 1;
+    std::vector<uint32_t> head(size_t(1) << HashBits, 0);
+    std::vector<uint32_t> chain(windowMask + 1, 0);
+    std::vector<Token> tokens;
+    tokens.reserve(size / 4);
+
+    auto insert = [&](size_t position)
+        {
+            if (position + MinMatch <= size)
+            {
+                uint32_t& first = head[Hash(data + position)];
+                chain[position & windowMask] = first;
+                first = static_cast<uint32_t>(position + 1);
+            }
+        };
+
+    size_t position = 0;
+
+    while (position < size)
+    {
+        uint32_t distance = 0;
+        int length = FindMatch(data, position, size, head, chain, m_maxChain, distance);
+        insert(position);
+
+        if (length < MinMatch)
+        {
+            tokens.push_back(Token{ 0, 0, data[position] });
+            position++;
+            continue;
+        }
+
+        while (length < m_lazyLength && position + 1 < size)
+        {
+            uint32_t nextDistance = 0;
+            int nextLength = FindMatch(data, position + 1, size, head, chain, (length >= m_goodLength) ? m_maxChain >> 2 : m_maxChain, nextDistance);
+
+            if (nextLength <= length)
+            {
+                break;
+            }
+
+            tokens.push_back(Token{ 0, 0, data[position] });
+            position++;
+            insert(position);
+            length = nextLength;
+            distance = nextDistance;
+        }
+
+        tokens.push_back(Token{ distance, static_cast<uint16_t>(length), 0 });
+
+        for (size_t next = position + 1; next < position + length; next++)
+        {
+            insert(next);
+        }
+
+        position += length;
+    }
+
+    return tokens;
+}
+
+/* Поиск самого длинного совпадения по цепочке позиции. Сначала
+   сравниваются два байта, последним из которых кандидат мог бы превзойти
+   лучшую длину, и два первых байта: большинство кандидатов отсеивается
+   без полного сравнения */
+int Lz77Coder::FindMatch(const uint8_t* data, size_t position, size_t size, const std::vector<uint32_t>& head, const std::vector<uint32_t>& chain, int maxChain, uint32_t& distance) const
+{
+    if (position + MinMatch > size)
+    {
+        return 0;
+    }
+
+    const size_t windowSize = size_t(1) << m_windowBits;
+    const int maxLength = static_cast<int>(std::min<size_t>(MaxMatch, size - position));
+    const uint8_t* current = data + position;
+    int bestLength = MinMatch - 1;
+    uint32_t candidate = head[Hash(current)];
+
+    for (int step = 0; step < maxChain && candidate != 0; step++)
+    {
+        size_t start = candidate - 1;
+
+        if (position - start >= windowSize)
+        {
+            break;
+        }
+
+        const uint8_t* match = data + start;
+
+        if (Load16(match + bestLength - 1) == Load16(current + bestLength - 1) && Load16(match) == Load16(current))
+        {
+            int length = MatchLength(match, current, maxLength);
+
+            if (length > bestLength)
+            {
+                bestLength = length;
+                distance = static_cast<uint32_t>(position - start);
+
+                if (length >= m_niceLength || length == maxLength)
+                {
+                    break;
+                }
+            }
+        }
+
+        candidate = chain[start & (windowSize - 1)];
+    }
+
+    return (bestLength >= MinMatch) ? bestLength : 0;
+}
+
+/* Частоты символов обоих алфавитов по разбору */
+void Lz77Coder::CountSymbols(const std::vector<Token>& tokens, std::vector<uint64_t>& literalFrequencies, std::vector<uint64_t>& distanceFrequencies) const
+{
+    literalFrequencies.assign(LiteralSymbols, 0);
+    distanceFrequencies.assign(DistanceSymbols(m_windowBits), 0);
+    int extraBits;
+    uint32_t extra;
+
+    for (const Token& token : tokens)
+    {
+        if (token.m_length == 0)
+        {
+            literalFrequencies[token.m_literal]++;
+            continue;
+        }
+
+        literalFrequencies[256 + ValueCode(token.m_length - MinMatch, extraBits, extra)]++;
+        distanceFrequencies[ValueCode(token.m_distance - 1, extraBits, extra)]++;
+    }
+}
+
+int Lz77Coder::WindowBits() const
+{
+    return m_windowBits;
+}
+
+/* Расстояние до 2^windowBits - 1: старший бит v не выше windowBits - 1 */
+int Lz77Coder::DistanceSymbols(int windowBits)
+{
+    return 2 * windowBits;
+}
+
+/* Кодирование разбора: код литерала или длины, затем у совпадения -
+   дополнительные биты длины, код расстояния и его дополнительные биты */
+void Lz77Coder::EncodeTokens(const std::vector<Token>& tokens, const HuffmanTree::Code* literalCodes, const HuffmanTree::Code* distanceCodes, BitWriter& writer)
+{
+    int extraBits;
+    uint32_t extra;
+
+    for (const Token& token : tokens)
+    {
+        if (token.m_length == 0)
+        {
+            const HuffmanTree::Code& code = literalCodes[token.m_literal];
+            writer.WriteBits(code.m_bits, code.m_length);
+            continue;
+        }
+
+        const HuffmanTree::Code& lengthCode = literalCodes[256 + ValueCode(token.m_length - MinMatch, extraBits, extra)];
+        writer.WriteBits(lengthCode.m_bits, lengthCode.m_length);
+        writer.WriteBits(extra, extraBits);
+
+        const HuffmanTree::Code& distanceCode = distanceCodes[ValueCode(token.m_distance - 1, extraBits, extra)];
+        writer.WriteBits(distanceCode.m_bits, distanceCode.m_length);
+        writer.WriteBits(extra, extraBits);
+    }
+}
+
+/* Декодирование textLength байт. Каждый символ занимает хотя бы бит
+   и даёт не больше MaxMatch байт - по этой границе размер проверяется до
+   выделения памяти. Расстояние за начало текста и длина за его конец -
+   неверный код; чтение за концом данных проверяется один раз в конце.
+   После Refill коротких кодов и дополнительных битов совпадения хватает
+   на всё совпадение, длинные коды дозаполняют накопитель сами.
+   Совпадение с расстоянием от 8 байт копируется по 8 байт (копия может
+   перекрываться с источником, но читает только уже записанное), ближе -
+   по байту. При ошибке результат пуст */
+HuffmanTree::DecodeStatus Lz77Coder::Decode(const uint8_t* data, size_t size, size_t textLength, const HuffmanTree& literalTree, const HuffmanTree& distanceTree, std::string& decodedText)
+{
+    decodedText.clear();
+
+    if (textLength == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (textLength / MaxMatch > size * 8)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    std::vector<DecodeEntry> literalTable = BuildDecodeTable(literalTree);
+    std::vector<DecodeEntry> distanceTable = BuildDecodeTable(distanceTree);
+    std::vector<HuffmanTree::FlatNode> literalNodes = literalTree.BuildFlatTree();
+    std::vector<HuffmanTree::FlatNode> distanceNodes = distanceTree.BuildFlatTree();
+
+    decodedText.resize(textLength + CopySlack);
+    char* output = &decodedText[0];
+    size_t position = 0;
+    BitReader reader(data, size);
+
+    while (position < textLength)
+    {
+        if (reader.BitsAvailable() < MatchBits)
+        {
+            reader.Refill();
+        }
+
+        int symbol = DecodeSymbol(literalTable.data(), literalNodes, reader);
+
+        if (symbol < 256)
+        {
+            if (symbol < 0)
+            {
+                decodedText.clear();
+
+                return HuffmanTree::InvalidCode;
+            }
+
+            output[position++] = static_cast<char>(symbol);
+            continue;
+        }
+
+        if (symbol >= LiteralSymbols)
+        {
+            decodedText.clear();
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        if (reader.BitsAvailable() < MaxLengthExtraBits + LookupBits + MaxWindowBits)
+        {
+            reader.Refill();
+        }
+
+        int extraBits;
+        uint32_t lengthBase = CodeBase(symbol - 256, extraBits);
+        size_t length = MinMatch + lengthBase + static_cast<size_t>(reader.ReadBits(extraBits));
+        int distanceSymbol = DecodeSymbol(distanceTable.data(), distanceNodes, reader);
+
+        if (reader.BitsAvailable() < MaxWindowBits)
+        {
+            reader.Refill();
+        }
+
+        if (distanceSymbol < 0 || distanceSymbol >= DistanceSymbols(MaxWindowBits))
+        {
+            decodedText.clear();
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        uint32_t distanceBase = CodeBase(distanceSymbol, extraBits);
+        size_t distance = 1 + distanceBase + static_cast<size_t>(reader.ReadBits(extraBits));
+
+        if (distance > position || length > textLength - position)
+        {
+            decodedText.clear();
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        char* target = output + position;
+        const char* source = target - distance;
+
+        if (distance >= 8)
+        {
+            for (size_t offset = 0; offset < length; offset += 8)
+            {
+                std::memcpy(target + offset, source + offset, 8);
+            }
+        }
+        else
+        {
+            for (size_t offset = 0; offset < length; offset++)
+            {
+                target[offset] = source[offset];
+            }
+        }
+
+        position += length;
+    }
+
+    if (reader.IsOverrun())
+    {
+        decodedText.clear();
+
+        return HuffmanTree::TruncatedStream;
+    }
+
+    decodedText.resize(textLength);
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+/* Таблица по LookupBits битам: символ и длина кода для кодов не длиннее
+   LookupBits, остальные записи нулевые */
+std::vector<Lz77Coder::DecodeEntry> Lz77Coder::BuildDecodeTable(const HuffmanTree& tree)
+{
+    std::vector<DecodeEntry> table(1 << LookupBits, DecodeEntry{ 0, 0 });
+    std::vector<HuffmanTree::Code> codeTable = tree.BuildPackedCodeTable();
+
+    for (size_t symbol = 0; symbol < codeTable.size(); symbol++)
+    {
+        const HuffmanTree::Code& code = codeTable[symbol];
+
+        if (code.m_length == 0 || code.m_length > LookupBits)
+        {
+            continue;
+        }
+
+        size_t first = static_cast<size_t>(code.m_bits << (LookupBits - code.m_length));
+        size_t last = first + (size_t(1) << (LookupBits - code.m_length));
+
+        for (size_t index = first; index < last; index++)
+        {
+            table[index] = DecodeEntry{ static_cast<uint16_t>(symbol), static_cast<uint8_t>(code.m_length) };
+        }
+    }
+
+    return table;
+}
+
+/* Символ по таблице или, для длинных и неверных кодов, обходом копии
+   дерева бит за битом. -1 - неверный код */
+int Lz77Coder::DecodeSymbol(const DecodeEntry* table, const std::vector<HuffmanTree::FlatNode>& tree, BitReader& reader)
+{
+    const DecodeEntry& entry = table[reader.PeekBits(LookupBits)];
+
+    if (entry.m_length != 0)
+    {
+        reader.ConsumeBits(entry.m_length);
+
+        return entry.m_symbol;
+    }
+
+    int node = 0;
+
+    if (tree.empty())
+    {
+        return -1;
+    }
+
+    while (tree[node].m_left >= 0 || tree[node].m_right >= 0)
+    {
+        if (reader.BitsAvailable() == 0)
+        {
+            reader.Refill();
+        }
+
+        node = reader.ReadBits(1) ? tree[node].m_right : tree[node].m_left;
+
+        if (node < 0)
+        {
+            return -1;
+        }
+    }
+
+    return tree[node].m_symbol;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "HuffmanTree.h"
+
+/* Поиск повторов LZ77 перед кодами Хаффмана, как в DEFLATE.
+   Текст разбирается на литералы и совпадения (длина, расстояние) с уже
+   пройденной частью текста не дальше окна в 2^windowBits байт. Совпадения
+   ищутся по хеш-цепочкам: позиции с одинаковым хешем первых MinMatch байт
+   связаны в список от новых к старым. Уровень усилий задаёт, сколько
+   звеньев цепочки просматривается, какой длины совпадение считается
+   достаточным и проверяется ли следующая позиция (ленивое сопоставление).
+   Литералы и длины образуют один алфавит (байты 0..255 и LengthCodes кодов
+   длины), расстояния - другой, у каждого своё дерево Хаффмана; коды пишутся
+   в один поток битов в порядке разбора.
+   Код длины или расстояния задаёт диапазон, точное значение - идущие за
+   кодом дополнительные биты. Значения 0..3 кодируются сами собой, значение
+   v со старшим битом h - кодом 2h + следующий бит v и h - 1 младшими битами
+   v (длина хранится как v = длина - MinMatch, расстояние - как v = расстояние - 1). */
+class Lz77Coder
+{
+public:
+    static const int MinMatch = 3;
+    static const int MaxMatch = 258;
+    static const int MinWindowBits = 10;
+    static const int MaxWindowBits = 22;
+    static const int DefaultWindowBits = 16;
+    static const int MinLevel = 1;
+    static const int MaxLevel = 9;
+    static const int DefaultLevel = 6;
+    static const int LengthCodes = 16;                                                                  // Коды длин - символы 256..271
+    static const int LiteralSymbols = 256 + LengthCodes;                                                // Алфавит литералов и длин
+    static const uint64_t MaxTextBytes = 0xFFFFFFFE;                                                    // Позиции хеш-цепочек 32-битные
+
+    struct Token                                                                                        // Литерал (m_length == 0) или совпадение
+    {
+        uint32_t m_distance;
+        uint16_t m_length;
+        uint8_t m_literal;
+    };
+
+    explicit Lz77Coder(int windowBits = DefaultWindowBits, int level = DefaultLevel);                   // Значения вне диапазонов ограничиваются
+
+    std::vector<Token> Parse(const std::string& text) const;                                            // Разбор текста на литералы и совпадения
+
+    void CountSymbols(const std::vector<Token>& tokens, std::vector<uint64_t>& literalFrequencies, std::vector<uint64_t>& distanceFrequencies) const;
+
+    int WindowBits() const;
+
+    static int DistanceSymbols(int windowBits);                                                         // Размер алфавита расстояний для окна
+
+    static void EncodeTokens(const std::vector<Token>& tokens, const HuffmanTree::Code* literalCodes, const HuffmanTree::Code* distanceCodes, BitWriter& writer);
+
+    static HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t textLength, const HuffmanTree& literalTree, const HuffmanTree& distanceTree, std::string& decodedText);
+
+private:
+    static const int LookupBits = 10;                                                                   // Индекс таблиц декодера
+    static const int MaxLengthExtraBits = 6;                                                            // У последнего кода длины
+    static const int MatchBits = 2 * LookupBits + MaxLengthExtraBits + MaxWindowBits;                   // Совпадение с короткими кодами
+    static const int CopySlack = 8;                                                                     // Запас результата для копирования по 8 байт
+
+    struct DecodeEntry
+    {
+        uint16_t m_symbol;
+        uint8_t m_length;                                                                               // 0 - код длиннее LookupBits или неверный
+    };
+
+    int m_windowBits;
+    int m_maxChain;                                                                                     // Звеньев цепочки на поиск
+    int m_goodLength;                                                                                   // С такой длины ленивый поиск короче
+    int m_lazyLength;                                                                                   // Ленивый поиск до этой длины (0 - без него)
+    int m_niceLength;                                                                                   // Достаточная длина: поиск прекращается
+
+    int FindMatch(const uint8_t* data, size_t position, size_t size, const std::vector<uint32_t>& head, const std::vector<uint32_t>& chain, int maxChain, uint32_t& distance) const;
+
+    static std::vector<DecodeEntry> BuildDecodeTable(const HuffmanTree& tree);
+
+    static int DecodeSymbol(const DecodeEntry* table, const std::vector<HuffmanTree::FlatNode>& tree, BitReader& reader);
+};
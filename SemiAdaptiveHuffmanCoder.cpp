@@ -0,0 +1,177 @@
+#include "SemiAdaptiveHuffmanCoder.h"
+
+#include <algorithm>
+
+#include "HuffmanDecodeTable.h"
+#include "HuffmanKernels.h"
+
+/* Конструктор. Сдвиг затухания ограничивается 1..63: при 0 гистограмма
+   обнулялась бы целиком, а сдвиг 64-битного счётчика на 64 и больше
+   не определён */
+SemiAdaptiveHuffmanCoder::SemiAdaptiveHuffmanCoder(size_t rebuildInterval, int decayShift)
+    : m_rebuildInterval(std::max<size_t>(rebuildInterval, 1)), m_decayShift(std::min(std::max(decayShift, static_cast<int>(MinDecayShift)), static_cast<int>(MaxDecayShift)))
+{
+    Reset();
+}
+
+/* Начальное состояние: все символы равновероятны */
+void SemiAdaptiveHuffmanCoder::Reset()
+{
+    m_frequencies.assign(256, 0);
+    m_symbolsInInterval = 0;
+
+    m_tree.BuildHuffmanTree(Weights());
+    m_codeTable = m_tree.BuildPackedCodeTable();
+}
+
+/* Кодирование порции текста. Интервал может продолжаться в следующей
+   порции: символы до его конца кодируются одним вызовом ядра */
+void SemiAdaptiveHuffmanCoder::Encode(const std::string& text, BitWriter& writer)
+{
+    for (size_t position = 0; position < text.size(); )
+    {
+        size_t count = std::min(text.size() - position, m_rebuildInterval - m_symbolsInInterval);
+        HuffmanKernels::EncodeBytes(text.data() + position, count, m_codeTable.data(), m_codeTable.size(), writer);
+        HuffmanKernels::CountBytes(text.data() + position, count, m_frequencies.data());
+        m_symbolsInInterval += count;
+        position += count;
+
+        if (m_symbolsInInterval == m_rebuildInterval)
+        {
+            writer.WriteBits(SwitchTable() ? 1 : 0, 1);
+            Decay();
+        }
+    }
+}
+
+/* Кодирование текста отдельным потоком, с начального состояния */
+std::vector<uint8_t> SemiAdaptiveHuffmanCoder::Encode(const std::string& text)
+{
+    Reset();
+    BitWriter writer(text.size() / 2);
+    Encode(text, writer);
+
+    return writer.Finish();
+}
+
+/* Декодирование потока целиком, с начального состояния. Между битами
+   смены таблицы символы декодируются таблицей HuffmanDecodeTable, которая
+   перестраивается только вместе с деревом. Код занимает хотя бы бит,
+   поэтому число символов проверяется до выделения памяти */
+HuffmanTree::DecodeStatus SemiAdaptiveHuffmanCoder::Decode(const std::vector<uint8_t>& data, size_t symbolCount, std::string& decodedText)
+{
+    Reset();
+    decodedText.clear();
+
+    if (symbolCount > data.size() * 8)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    /* После Reset дерево у всех экземпляров одно (частоты равны), поэтому
+       его таблица строится один раз, а короткие потоки её только копируют */
+    static const HuffmanDecodeTable initialTable(m_tree);
+
+    decodedText.resize(symbolCount);
+    HuffmanDecodeTable decodeTable = initialTable;
+    BitReader reader(data.data(), data.size());
+
+    for (size_t position = 0; position < symbolCount; )
+    {
+        if (m_symbolsInInterval == m_rebuildInterval)
+        {
+            reader.Refill();
+
+            if (reader.ReadBits(1))
+            {
+                m_tree.BuildHuffmanTree(Weights());
+                decodeTable = HuffmanDecodeTable(m_tree);
+            }
+
+            Decay();
+        }
+
+        size_t count = std::min(symbolCount - position, m_rebuildInterval - m_symbolsInInterval);
+        HuffmanTree::DecodeStatus status = decodeTable.Decode(reader, count, &decodedText[position]);
+
+        if (status != HuffmanTree::DecodeSuccess)
+        {
+            decodedText.clear();
+
+            return status;
+        }
+
+        HuffmanKernels::CountBytes(decodedText.data() + position, count, m_frequencies.data());
+        m_symbolsInInterval += count;
+        position += count;
+    }
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+std::string SemiAdaptiveHuffmanCoder::Decode(const std::vector<uint8_t>& data, size_t symbolCount)
+{
+    std::string decodedText;
+    Decode(data, symbolCount, decodedText);
+
+    return decodedText;
+}
+
+std::vector<uint64_t> SemiAdaptiveHuffmanCoder::Weights() const
+{
+    std::vector<uint64_t> weights(m_frequencies.size());
+
+    for (size_t symbol = 0; symbol < m_frequencies.size(); symbol++)
+    {
+        weights[symbol] = std::max<uint64_t>(m_frequencies[symbol], 1);
+    }
+
+    return weights;
+}
+
+/* Новая таблица принимается, только если она кодирует накопленную
+   гистограмму короче хотя бы на 1/2^SwitchMarginShift и её коды
+   помещаются в одну запись BitWriter. Порог нужен декодеру: перестройка
+   таблицы HuffmanDecodeTable дольше декодирования целого интервала, а
+   мелкие выигрыши после затухания возникают почти на каждом интервале */
+bool SemiAdaptiveHuffmanCoder::SwitchTable()
+{
+    m_candidate.BuildHuffmanTree(Weights());
+    std::vector<HuffmanTree::Code> candidateTable = m_candidate.BuildPackedCodeTable();
+    bool fits = std::all_of(candidateTable.begin(), candidateTable.end(), [](const HuffmanTree::Code& code) { return code.m_length <= BitWriter::MaxWriteBits; });
+
+    uint64_t cost = Cost(m_frequencies, m_codeTable);
+
+    if (!fits || Cost(m_frequencies, candidateTable) + (cost >> SwitchMarginShift) >= cost)
+    {
+        return false;
+    }
+
+    std::swap(m_tree, m_candidate);
+    m_codeTable.swap(candidateTable);
+
+    return true;
+}
+
+void SemiAdaptiveHuffmanCoder::Decay()
+{
+    for (uint64_t& frequency : m_frequencies)
+    {
+        frequency -= frequency >> m_decayShift;
+    }
+
+    m_symbolsInInterval = 0;
+}
+
+/* Длина гистограммы в битах при данной таблице кодов */
+uint64_t SemiAdaptiveHuffmanCoder::Cost(const std::vector<uint64_t>& frequencies, const std::vector<HuffmanTree::Code>& codeTable)
+{
+    uint64_t cost = 0;
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        cost += frequencies[symbol] * static_cast<uint64_t>(codeTable[symbol].m_length);
+    }
+
+    return cost;
+}
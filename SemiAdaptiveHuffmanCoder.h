@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "HuffmanTree.h"
+
+/* Полуадаптивный кодер Хаффмана.
+   Ведёт гистограмму уже переданных символов и каждые rebuildInterval байт
+   строит новое дерево по затухающим частотам. Внутри интервала символы
+   кодируются упакованной таблицей кодов (HuffmanKernels::EncodeBytes)
+   и декодируются табличным декодером HuffmanDecodeTable, то есть со
+   скоростью статической таблицы. После каждого интервала в поток пишется
+   один бит: 1 - переход на новую таблицу, 0 - старая таблица остаётся.
+   Декодер повторяет ту же гистограмму и перестраивает дерево и таблицу
+   декодера только по сигналу, так что сами таблицы в поток не передаются. */
+class SemiAdaptiveHuffmanCoder
+{
+public:
+    static const int MinDecayShift = 1;
+    static const int MaxDecayShift = 63;
+
+    SemiAdaptiveHuffmanCoder(size_t rebuildInterval = 4 * 1024, int decayShift = 1);                    // Конструктор (сдвиг ограничивается 1..63)
+
+    void Reset();                                                                                       // Возврат в начальное состояние
+
+    void Encode(const std::string& text, BitWriter& writer);                                            // Кодирование очередной порции текста (дописывает биты)
+
+    std::vector<uint8_t> Encode(const std::string& text);                                               // Кодирование текста
+
+    HuffmanTree::DecodeStatus Decode(const std::vector<uint8_t>& data, size_t symbolCount, std::string& decodedText);
+
+    std::string Decode(const std::vector<uint8_t>& data, size_t symbolCount);                           // Декодирование текста (пустая строка при ошибке)
+
+private:
+    static const int SwitchMarginShift = 6;                                                             // Новая таблица должна быть короче на 1/2^shift
+
+    size_t m_rebuildInterval;                                                                           // Длина интервала в символах
+    int m_decayShift;                                                                                   // Затухание: счётчик теряет 1/2^shift за интервал
+
+    std::vector<uint64_t> m_frequencies;                                                                // Затухающая гистограмма
+    size_t m_symbolsInInterval;
+
+    HuffmanTree m_tree;                                                                                 // Текущее дерево
+    HuffmanTree m_candidate;                                                                            // Дерево-кандидат кодера (пул узлов переиспользуется)
+    std::vector<HuffmanTree::Code> m_codeTable;                                                         // Текущая таблица кодера
+
+    std::vector<uint64_t> Weights() const;                                                              // Частоты для построения (не меньше 1)
+
+    bool SwitchTable();                                                                                 // Конец интервала у кодера: выбор таблицы
+
+    void Decay();                                                                                       // Затухание гистограммы в конце интервала
+
+    static uint64_t Cost(const std::vector<uint64_t>& frequencies, const std::vector<HuffmanTree::Code>& codeTable);
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "HuffmanDecodeTable.h"
+
+/* Таблицы статического кодека, вычисляемые при компиляции.
+   Для распределений, известных заранее, дерево, коды и таблица декодера
+   строятся constexpr-функцией BuildStaticHuffmanTables и попадают в .rodata:
+
+       constexpr std::array<int, 256> messageFrequencies = { ... };
+       constexpr StaticHuffmanTables messageTables = BuildStaticHuffmanTables(messageFrequencies);
+       using MessageCodec = StaticHuffmanCodec<messageTables>;
+
+   Дерево строится тем же алгоритмом, что и HuffmanTree::BuildHuffmanTree
+   (стабильная сортировка по частоте, слияние двух первых узлов, новый узел
+   в конец списка), поэтому коды совпадают с кодами дерева по тем же частотам. */
+struct StaticHuffmanTables
+{
+    static const int AlphabetSize = 256;
+    static const int MaxNodes = 2 * AlphabetSize - 1;
+    static const int TableSize = 1 << HuffmanDecodeTable::LookupBits;
+
+    struct DecodeEntry                                                                                  // Та же запись, что у HuffmanDecodeTable
+    {
+        uint8_t m_symbols[HuffmanDecodeTable::MaxSymbolsPerEntry];
+        uint8_t m_count;
+        uint8_t m_bits;
+        uint8_t m_firstBits;
+    };
+
+    uint64_t m_codes[AlphabetSize];
+    uint8_t m_lengths[AlphabetSize];
+    int m_minLength;                                                                                    // 0 - кодов нет
+    int m_maxLength;
+
+    int16_t m_left[MaxNodes];                                                                           // Дерево для кодов длиннее LookupBits
+    int16_t m_right[MaxNodes];
+    uint8_t m_nodeSymbols[MaxNodes];
+    int m_root;                                                                                         // -1 - пустое дерево
+
+    DecodeEntry m_entries[TableSize];
+};
+
+constexpr StaticHuffmanTables BuildStaticHuffmanTables(const std::array<int, StaticHuffmanTables::AlphabetSize>& frequencies)
+{
+    const int lookupBits = HuffmanDecodeTable::LookupBits;
+    const int maxSymbols = HuffmanDecodeTable::MaxSymbolsPerEntry;
+    const int tableMask = StaticHuffmanTables::TableSize - 1;
+
+    StaticHuffmanTables tables{};
+    long long weights[StaticHuffmanTables::MaxNodes] = {};
+    bool present[StaticHuffmanTables::AlphabetSize] = {};
+    int nodeCount = 0;
+
+    /* Листья в порядке символов, затем стабильная сортировка вставками по частоте */
+    for (int symbol = 0; symbol < StaticHuffmanTables::AlphabetSize; symbol++)
+    {
+        if (frequencies[symbol] > 0)
+        {
+            int node = nodeCount++;
+
+            while (node > 0 && weights[node - 1] > frequencies[symbol])
+            {
+                weights[node] = weights[node - 1];
+                tables.m_nodeSymbols[node] = tables.m_nodeSymbols[node - 1];
+                node--;
+            }
+
+            weights[node] = frequencies[symbol];
+            tables.m_nodeSymbols[node] = static_cast<uint8_t>(symbol);
+            present[symbol] = true;
+        }
+    }
+
+    for (int node = 0; node < nodeCount; node++)
+    {
+        tables.m_left[node] = -1;
+        tables.m_right[node] = -1;
+    }
+
+    /* Отсортированный список BuildHuffmanTree - это слияние двух очередей:
+       листьев и новых узлов (в порядке создания, частоты не убывают); при
+       равной частоте лист стоит раньше нового узла */
+    int leafCount = nodeCount;
+    int leafHead = 0;
+    int mergedHead = leafCount;
+
+    auto popSmallest = [&]()
+    {
+        if (leafHead < leafCount && (mergedHead == nodeCount || weights[leafHead] <= weights[mergedHead]))
+        {
+            return leafHead++;
+        }
+
+        return mergedHead++;
+    };
+
+    /* Единственный символ получает код "0", как в HuffmanTree */
+    if (leafCount == 1)
+    {
+        weights[nodeCount] = weights[0];
+        tables.m_left[nodeCount] = 0;
+        tables.m_right[nodeCount] = -1;
+        nodeCount++;
+        leafHead = leafCount;
+        mergedHead = nodeCount;
+    }
+
+    while ((leafCount - leafHead) + (nodeCount - mergedHead) > 1)
+    {
+        int node1 = popSmallest();
+        int node2 = popSmallest();
+
+        weights[nodeCount] = weights[node1] + weights[node2];
+        tables.m_left[nodeCount] = static_cast<int16_t>(node1);
+        tables.m_right[nodeCount] = static_cast<int16_t>(node2);
+        nodeCount++;
+    }
+
+    tables.m_root = nodeCount - 1;
+
+    /* Коды: обход дерева с явным стеком */
+    int stackNodes[StaticHuffmanTables::MaxNodes] = {};
+    uint64_t stackCodes[StaticHuffmanTables::MaxNodes] = {};
+    int stackLengths[StaticHuffmanTables::MaxNodes] = {};
+    int stackSize = 0;
+
+    if (tables.m_root >= 0)
+    {
+        stackNodes[stackSize++] = tables.m_root;
+    }
+
+    while (stackSize > 0)
+    {
+        stackSize--;
+        int node = stackNodes[stackSize];
+        uint64_t code = stackCodes[stackSize];
+        int length = stackLengths[stackSize];
+
+        if (tables.m_left[node] < 0)
+        {
+            tables.m_codes[tables.m_nodeSymbols[node]] = code;
+            tables.m_lengths[tables.m_nodeSymbols[node]] = static_cast<uint8_t>(length);
+            tables.m_minLength = (tables.m_minLength == 0 || length < tables.m_minLength) ? length : tables.m_minLength;
+            tables.m_maxLength = (length > tables.m_maxLength) ? length : tables.m_maxLength;
+            continue;
+        }
+
+        stackNodes[stackSize] = tables.m_left[node];
+        stackCodes[stackSize] = code << 1;
+        stackLengths[stackSize++] = length + 1;
+
+        if (tables.m_right[node] >= 0)
+        {
+            stackNodes[stackSize] = tables.m_right[node];
+            stackCodes[stackSize] = (code << 1) | 1;
+            stackLengths[stackSize++] = length + 1;
+        }
+    }
+
+    /* Таблица декодера - так же, как в HuffmanDecodeTable */
+    int symbols[StaticHuffmanTables::TableSize] = {};
+    int lengths[StaticHuffmanTables::TableSize] = {};
+
+    for (int index = 0; index <= tableMask; index++)
+    {
+        symbols[index] = -1;
+    }
+
+    for (int symbol = 0; symbol < StaticHuffmanTables::AlphabetSize; symbol++)
+    {
+        int length = tables.m_lengths[symbol];
+
+        if (!present[symbol] || length > lookupBits)
+        {
+            continue;
+        }
+
+        int first = static_cast<int>(tables.m_codes[symbol] << (lookupBits - length));
+        int last = first + (1 << (lookupBits - length));
+
+        for (int index = first; index < last; index++)
+        {
+            symbols[index] = symbol;
+            lengths[index] = length;
+        }
+    }
+
+    for (int index = 0; index <= tableMask; index++)
+    {
+        StaticHuffmanTables::DecodeEntry& entry = tables.m_entries[index];
+        int used = 0;
+
+        while (entry.m_count < maxSymbols)
+        {
+            int next = (index << used) & tableMask;
+
+            if (symbols[next] < 0 || lengths[next] > lookupBits - used)
+            {
+                break;
+            }
+
+            entry.m_symbols[entry.m_count++] = static_cast<uint8_t>(symbols[next]);
+            used += lengths[next];
+        }
+
+        entry.m_bits = static_cast<uint8_t>(used);
+        entry.m_firstBits = static_cast<uint8_t>(lengths[index]);
+    }
+
+    return tables;
+}
+
+/* Класс "Статический кодек": кодер и декодер, специализированные таблицами Tables.
+   Декодер проверяет данные, как HuffmanDecodeTable: число символов больше,
+   чем помещается в данные кодами наименьшей длины, даёт OutputOverrun ещё до
+   выделения памяти, переход к отсутствующему потомку (у дерева из одного
+   символа нет кода "1", у пустого нет ни одного) - InvalidCode, чтение
+   за концом данных - TruncatedStream.
+   Кодируются только символы с ненулевой частотой в таблицах: у остальных
+   нет кода, и Encode для текста с ними возвращает false */
+template <const StaticHuffmanTables& Tables>
+class StaticHuffmanCodec
+{
+public:
+    static_assert(Tables.m_maxLength <= BitWriter::MaxWriteBits, "Код длиннее одной записи BitWriter");
+
+    static bool Encode(const std::string& text, std::vector<uint8_t>& encodedData)                      // Кодирование текста (false - символ без кода)
+    {
+        BitWriter writer(text.size() / 2);
+        bool missing = false;
+
+        for (char huffmanChar : text)
+        {
+            unsigned char symbol = static_cast<unsigned char>(huffmanChar);
+            missing |= Tables.m_lengths[symbol] == 0;
+            writer.WriteBits(Tables.m_codes[symbol], Tables.m_lengths[symbol]);
+        }
+
+        if (missing)
+        {
+            encodedData.clear();
+
+            return false;
+        }
+
+        encodedData = writer.Finish();
+
+        return true;
+    }
+
+    static HuffmanTree::DecodeStatus Decode(const std::vector<uint8_t>& data, size_t symbolCount, std::string& decodedText)
+    {
+        const int maxSymbols = HuffmanDecodeTable::MaxSymbolsPerEntry;
+        decodedText.clear();
+
+        if (symbolCount == 0)
+        {
+            return HuffmanTree::DecodeSuccess;
+        }
+
+        if (Tables.m_minLength == 0)
+        {
+            return HuffmanTree::InvalidCode;
+        }
+
+        if (symbolCount > data.size() * 8 / Tables.m_minLength)
+        {
+            return HuffmanTree::OutputOverrun;
+        }
+
+        decodedText.assign(symbolCount + maxSymbols, '\0');
+        char* output = &decodedText[0];
+        size_t position = 0;
+        BitReader reader(data.data(), data.size());
+
+        while (position < symbolCount)
+        {
+            if (reader.IsOverrun())
+            {
+                decodedText.clear();
+
+                return HuffmanTree::TruncatedStream;
+            }
+
+            reader.Refill();
+            const StaticHuffmanTables::DecodeEntry& entry = Tables.m_entries[reader.PeekBits(HuffmanDecodeTable::LookupBits)];
+
+            if (entry.m_count == 0)
+            {
+                if (!DecodeSymbol(reader, output[position++]))
+                {
+                    decodedText.clear();
+
+                    return HuffmanTree::InvalidCode;
+                }
+            }
+            else if (position + maxSymbols <= symbolCount)
+            {
+                std::memcpy(output + position, entry.m_symbols, maxSymbols);
+                position += entry.m_count;
+                reader.ConsumeBits(entry.m_bits);
+            }
+            else
+            {
+                output[position++] = static_cast<char>(entry.m_symbols[0]);
+                reader.ConsumeBits(entry.m_firstBits);
+            }
+        }
+
+        if (reader.IsOverrun())
+        {
+            decodedText.clear();
+
+            return HuffmanTree::TruncatedStream;
+        }
+
+        decodedText.resize(symbolCount);
+
+        return HuffmanTree::DecodeSuccess;
+    }
+
+private:
+    static bool DecodeSymbol(BitReader& reader, char& symbol)                                           // Обход дерева для длинных и неверных кодов
+    {
+        int node = Tables.m_root;
+
+        while (node >= 0 && Tables.m_left[node] >= 0)
+        {
+            if (reader.BitsAvailable() == 0)
+            {
+                reader.Refill();
+            }
+
+            node = reader.ReadBits(1) ? Tables.m_right[node] : Tables.m_left[node];
+        }
+
+        if (node < 0)
+        {
+            return false;
+        }
+
+        symbol = static_cast<char>(Tables.m_nodeSymbols[node]);
+
+        return true;
+    }
+};
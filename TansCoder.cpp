@@ -0,0 +1,328 @@
+#include "TansCoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* Номер старшего единичного бита */
+static int HighBit(uint32_t value)
+{
+    return 31 - __builtin_clz(value);
+}
+
+/* Построение таблиц. Символы раскладываются по состояниям шагом
+   L/2 + L/8 + 3 (нечётный, поэтому обходит все L позиций), так что
+   состояния одного символа разбросаны по таблице. k-е по порядку
+   состояние символа с частотой n соответствует промежуточному значению
+   x = n + k из [n, 2n): декодер дополняет x битами до [L, 2L), кодер
+   отбрасывает младшие биты состояния, пока оно не попадёт в [n, 2n) */
+TansCoder::TansCoder(const std::vector<int>& counts, int tableLog)
+    : m_tableLog(tableLog), m_decodeTable(size_t(1) << tableLog), m_stateTable(size_t(1) << tableLog), m_symbols(256, SymbolTransform{ 0, 0 })
+{
+    const int tableSize = 1 << tableLog;
+    const int step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    std::vector<uint8_t> spread(tableSize);
+    std::vector<int> cumulative(256, 0);
+    int position = 0;
+    int total = 0;
+
+    for (int symbol = 0; symbol < 256; symbol++)
+    {
+        cumulative[symbol] = total;
+        total += counts[symbol];
+        m_maxCount = std::max(m_maxCount, counts[symbol]);
+
+        for (int occurrence = 0; occurrence < counts[symbol]; occurrence++)
+        {
+            spread[position] = static_cast<uint8_t>(symbol);
+            position = (position + step) & (tableSize - 1);
+        }
+    }
+
+    std::vector<int> next(counts.begin(), counts.end());
+
+    for (int state = 0; state < tableSize; state++)
+    {
+        int symbol = spread[state];
+        int x = next[symbol]++;
+        int bits = tableLog - HighBit(static_cast<uint32_t>(x));
+
+        m_stateTable[cumulative[symbol] + x - counts[symbol]] = static_cast<uint16_t>(tableSize + state);
+        m_decodeTable[state] = DecodeEntry{ static_cast<uint16_t>((x << bits) - tableSize), static_cast<uint8_t>(symbol), static_cast<uint8_t>(bits) };
+    }
+
+    /* Для состояния S кодер отдаёт maxBits битов, если S >= n << maxBits,
+       иначе на бит меньше: сравнение заменено переносом в 16-й разряд */
+    for (int symbol = 0; symbol < 256; symbol++)
+    {
+        int count = counts[symbol];
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        int maxBits = (count == 1) ? tableLog : tableLog - HighBit(static_cast<uint32_t>(count - 1));
+        m_symbols[symbol].m_deltaBits = (maxBits << 16) - (count << maxBits);
+        m_symbols[symbol].m_deltaState = cumulative[symbol] - count;
+    }
+}
+
+/* Шаг кодера: младшие биты состояния в symbolBits и переход */
+inline uint32_t TansCoder::EncodeSymbol(uint32_t state, uint8_t symbol, uint32_t& symbolBits) const
+{
+    const SymbolTransform& transform = m_symbols[symbol];
+    uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(state) + transform.m_deltaBits) >> 16;
+    symbolBits = (state & ((uint32_t(1) << bits) - 1)) << 4 | bits;
+
+    return m_stateTable[static_cast<int32_t>(state >> bits) + transform.m_deltaState];
+}
+
+/* Кодирование с конца текста двумя состояниями: чётные символы меняют
+   первое, нечётные - второе. Биты символов копятся в pending (биты << 4 |
+   их число) и записываются после конечных состояний в прямом порядке */
+void TansCoder::Encode(const void* data, size_t size, BitWriter& writer) const
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint32_t tableSize = uint32_t(1) << m_tableLog;
+    std::vector<uint32_t> pending(size);
+    uint32_t first = tableSize;
+    uint32_t second = tableSize;
+    size_t position = size;
+
+    if (position & 1)
+    {
+        position--;
+        first = EncodeSymbol(first, bytes[position], pending[position]);
+    }
+
+    while (position > 0)
+    {
+        position -= 2;
+        second = EncodeSymbol(second, bytes[position + 1], pending[position + 1]);
+        first = EncodeSymbol(first, bytes[position], pending[position]);
+    }
+
+    writer.WriteBits(first - tableSize, m_tableLog);
+    writer.WriteBits(second - tableSize, m_tableLog);
+
+    /* По несколько символов за запись: каждый не длиннее MaxTableLog битов */
+    uint64_t group = 0;
+    int groupBits = 0;
+
+    for (uint32_t symbolBits : pending)
+    {
+        int bits = static_cast<int>(symbolBits & 15);
+
+        if (groupBits + bits > BitWriter::MaxWriteBits)
+        {
+            writer.WriteBits(group, groupBits);
+            group = 0;
+            groupBits = 0;
+        }
+
+        group = (group << bits) | (symbolBits >> 4);
+        groupBits += bits;
+    }
+
+    writer.WriteBits(group, groupBits);
+}
+
+/* Декодирование. Два состояния чередуются, так что поиски в таблице для
+   соседних символов не ждут друг друга. Символ читает не больше
+   MaxTableLog битов, поэтому после Refill хватает на 4 символа. Число
+   символов ограничивается до выделения памяти (MaxSymbolCount), чтение
+   за концом данных и конечные состояния проверяются в конце. При ошибке
+   результат пуст */
+HuffmanTree::DecodeStatus TansCoder::Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    if (symbolCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (symbolCount > MaxSymbolCount(size))
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    decodedText.resize(symbolCount);
+    char* output = &decodedText[0];
+    const DecodeEntry* table = m_decodeTable.data();
+    BitReader reader(data, size);
+    uint32_t first = static_cast<uint32_t>(reader.ReadBits(m_tableLog));
+    uint32_t second = static_cast<uint32_t>(reader.ReadBits(m_tableLog));
+    size_t position = 0;
+
+    for (; position + 4 <= symbolCount; position += 4)
+    {
+        reader.Refill();
+
+        for (int pair = 0; pair < 4; pair += 2)
+        {
+            DecodeEntry firstEntry = table[first];
+            DecodeEntry secondEntry = table[second];
+            output[position + pair] = static_cast<char>(firstEntry.m_symbol);
+            output[position + pair + 1] = static_cast<char>(secondEntry.m_symbol);
+            first = firstEntry.m_nextState + static_cast<uint32_t>(reader.ReadBits(firstEntry.m_bits));
+            second = secondEntry.m_nextState + static_cast<uint32_t>(reader.ReadBits(secondEntry.m_bits));
+        }
+    }
+
+    for (; position < symbolCount; position++)
+    {
+        reader.Refill();
+        uint32_t& state = (position & 1) ? second : first;
+        const DecodeEntry& entry = table[state];
+        output[position] = static_cast<char>(entry.m_symbol);
+        state = entry.m_nextState + static_cast<uint32_t>(reader.ReadBits(entry.m_bits));
+    }
+
+    if (reader.IsOverrun())
+    {
+        decodedText.clear();
+
+        return HuffmanTree::TruncatedStream;
+    }
+
+    if (first != 0 || second != 0)
+    {
+        decodedText.clear();
+
+        return HuffmanTree::InvalidCode;
+    }
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+/* Символ без чтения битов бывает только у частоты n > L/2 и переводит
+   состояние u в n + k - L, где k <= u - номер состояния среди состояний
+   символа, то есть уменьшает u хотя бы на d = L - наибольшая частота.
+   Поэтому каждое из двух состояний декодирует подряд без чтения не больше
+   (L - 1) / d + 1 символов, а остальные символы читают хотя бы бит */
+uint64_t TansCoder::MaxSymbolCount(size_t size) const
+{
+    uint64_t tableSize = uint64_t(1) << m_tableLog;
+    uint64_t run = (tableSize - 1) / (tableSize - m_maxCount) + 1;
+
+    return (static_cast<uint64_t>(size) * 8 + 1) * (2 * run + 1);
+}
+
+/* Нормирование. Символы с долей меньше 1/L получают частоту 1, остаток
+   таблицы делится между остальными пропорционально; расхождение суммы
+   с L после округления исправляется по единице там, где это дешевле
+   всего по оценке f * log2(n / (n - 1)) (увеличение - где выгоднее).
+   Меньше двух символов не нормируются (пустой результат): у единственного
+   символа частота L и нулевая длина, такой текст tANS не кодирует */
+std::vector<int> TansCoder::NormalizeCounts(const std::vector<uint64_t>& frequencies, int tableLog)
+{
+    const int tableSize = 1 << tableLog;
+    uint64_t total = 0;
+    int usedSymbols = 0;
+
+    for (uint64_t frequency : frequencies)
+    {
+        total += frequency;
+        usedSymbols += (frequency > 0);
+    }
+
+    if (frequencies.size() > 256 || usedSymbols < 2 || usedSymbols > tableSize)
+    {
+        return std::vector<int>();
+    }
+
+    std::vector<int> counts(256, 0);
+    uint64_t rareTotal = 0;
+    int rareSymbols = 0;
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if (frequencies[symbol] > 0 && static_cast<double>(frequencies[symbol]) * tableSize < static_cast<double>(total))
+        {
+            counts[symbol] = 1;
+            rareTotal += frequencies[symbol];
+            rareSymbols++;
+        }
+    }
+
+    double scale = static_cast<double>(tableSize - rareSymbols) / static_cast<double>(total - rareTotal);
+    int sum = rareSymbols;
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if (frequencies[symbol] > 0 && counts[symbol] == 0)
+        {
+            counts[symbol] = std::max(1, static_cast<int>(std::llround(static_cast<double>(frequencies[symbol]) * scale)));
+            sum += counts[symbol];
+        }
+    }
+
+    while (sum != tableSize)
+    {
+        int change = (sum < tableSize) ? 1 : -1;
+        int best = -1;
+        double bestCost = 0;
+
+        for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+        {
+            if (counts[symbol] == 0 || counts[symbol] + change == 0)
+            {
+                continue;
+            }
+
+            double cost = static_cast<double>(frequencies[symbol]) * std::log2(static_cast<double>(counts[symbol]) / (counts[symbol] + change));
+
+            if (best < 0 || cost < bestCost)
+            {
+                best = static_cast<int>(symbol);
+                bestCost = cost;
+            }
+        }
+
+        counts[best] += change;
+        sum += change;
+    }
+
+    return counts;
+}
+
+bool TansCoder::CheckCounts(const std::vector<int>& counts, int tableLog)
+{
+    if (tableLog < MinTableLog || tableLog > MaxTableLog || counts.size() != 256)
+    {
+        return false;
+    }
+
+    int sum = 0;
+    int usedSymbols = 0;
+
+    for (int count : counts)
+    {
+        if (count < 0 || count > (1 << tableLog))
+        {
+            return false;
+        }
+
+        sum += count;
+        usedSymbols += (count > 0);
+    }
+
+    return sum == (1 << tableLog) && usedSymbols >= 2;
+}
+
+/* Оценка длины данных: log2(L / n) битов на символ и начальное состояние */
+uint64_t TansCoder::EstimateBits(const std::vector<uint64_t>& frequencies, const std::vector<int>& counts, int tableLog)
+{
+    double bits = tableLog;
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if (frequencies[symbol] > 0)
+        {
+            bits += static_cast<double>(frequencies[symbol]) * (tableLog - std::log2(static_cast<double>(counts[symbol])));
+        }
+    }
+
+    return static_cast<uint64_t>(std::ceil(bits));
+}
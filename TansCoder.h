@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "HuffmanTree.h"
+
+/* Табличный ANS (tANS, как в FSE) для байтового алфавита.
+   Частоты нормируются к сумме L = 2^tableLog, символы раскладываются по L
+   состояниям; символ с нормированной частотой n стоит в среднем
+   log2(L / n) битов - дробную часть бита, которую теряют целые длины кодов
+   Хаффмана. Выигрыш заметен на перекошенных распределениях (один символ
+   чаще половины), где код Хаффмана не короче 1 бита.
+   Кодер идёт по тексту с конца и запоминает биты каждого символа, затем
+   пишет конечные состояния и биты в прямом порядке, поэтому декодер
+   читает поток вперёд тем же BitReader: поиск в таблице состояний и
+   чтение 0..tableLog битов на символ. Состояний два (чётные и нечётные
+   символы), чтобы цепочки зависимостей декодера шли параллельно.
+   Декодер заканчивает в начальных состояниях кодера - это проверка
+   целостности данных. */
+class TansCoder
+{
+public:
+    static const int MinTableLog = 5;
+    static const int MaxTableLog = 12;
+    static const int DefaultTableLog = 12;
+
+    TansCoder(const std::vector<int>& counts, int tableLog);                                            // Таблицы по нормированным частотам (CheckCounts)
+
+    void Encode(const void* data, size_t size, BitWriter& writer) const;                                // Кодирование байтов
+
+    HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t symbolCount, std::string& decodedText) const;
+
+    uint64_t MaxSymbolCount(size_t size) const;                                                         // Наибольшее число символов в size байт данных
+
+    static std::vector<int> NormalizeCounts(const std::vector<uint64_t>& frequencies, int tableLog);
+
+    static bool CheckCounts(const std::vector<int>& counts, int tableLog);                              // Частоты пригодны для таблиц
+
+    static uint64_t EstimateBits(const std::vector<uint64_t>& frequencies, const std::vector<int>& counts, int tableLog);
+
+private:
+    struct DecodeEntry
+    {
+        uint16_t m_nextState;                                                                           // Основание следующего состояния
+        uint8_t m_symbol;
+        uint8_t m_bits;                                                                                 // Битов прочитать к основанию
+    };
+
+    struct SymbolTransform                                                                              // Переход кодера для символа
+    {
+        int32_t m_deltaBits;                                                                            // (состояние + m_deltaBits) >> 16 - число битов
+        int32_t m_deltaState;                                                                           // Смещение в m_stateTable
+    };
+
+    int m_tableLog;
+    int m_maxCount = 0;
+    std::vector<DecodeEntry> m_decodeTable;
+    std::vector<uint16_t> m_stateTable;                                                                 // Состояния кодера L..2L-1 по символам
+    std::vector<SymbolTransform> m_symbols;
+
+    uint32_t EncodeSymbol(uint32_t state, uint8_t symbol, uint32_t& symbolBits) const;                  // Шаг кодера, возвращает новое состояние
+};
@@ -0,0 +1,236 @@
+#include "Utf8Alphabet.h"
+
+#include <algorithm>
+
+/* Конструктор */
+Utf8Alphabet::Utf8Alphabet()
+    : m_twoByteSymbols(TwoByteLimit, -1)
+{
+}
+
+/* Алфавит по списку кодовых точек из заголовка блока: точки должны идти
+   строго по возрастанию и быть правильными точками вне ASCII */
+bool Utf8Alphabet::Assign(const std::vector<uint32_t>& codePoints)
+{
+    m_codePoints.clear();
+    m_twoByteSymbols.assign(TwoByteLimit, -1);
+    m_otherSymbols.clear();
+
+    for (size_t index = 0; index < codePoints.size(); index++)
+    {
+        uint32_t codePoint = codePoints[index];
+
+        if (codePoint < 0x80 || codePoint > MaxCodePoint || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            return false;
+        }
+
+        if (index > 0 && codePoint <= codePoints[index - 1])
+        {
+            return false;
+        }
+
+        int symbol = ByteSymbols + static_cast<int>(index);
+
+        if (codePoint < TwoByteLimit)
+        {
+            m_twoByteSymbols[codePoint] = symbol;
+        }
+        else
+        {
+            m_otherSymbols[codePoint] = symbol;
+        }
+    }
+
+    m_codePoints = codePoints;
+
+    return true;
+}
+
+/* Первый проход: подсчёт байтов и кодовых точек, затем алфавит из
+   встретившихся точек и частоты в нумерации символов алфавита */
+void Utf8Alphabet::Build(const std::string& text, std::vector<uint64_t>& frequencies)
+{
+    std::vector<uint64_t> byteCounts(ByteSymbols, 0);
+    std::vector<uint64_t> twoByteCounts(TwoByteLimit, 0);
+    std::unordered_map<uint32_t, uint64_t> otherCounts;
+
+    for (size_t position = 0; position < text.size(); )
+    {
+        unsigned char byte = static_cast<unsigned char>(text[position]);
+        uint32_t codePoint;
+        int length = (byte < 0x80) ? 0 : DecodeCodePoint(text, position, codePoint);
+
+        if (length == 0)
+        {
+            byteCounts[byte]++;
+            position++;
+        }
+        else
+        {
+            if (codePoint < TwoByteLimit)
+            {
+                twoByteCounts[codePoint]++;
+            }
+            else
+            {
+                otherCounts[codePoint]++;
+            }
+
+            position += length;
+        }
+    }
+
+    std::vector<uint32_t> codePoints;
+
+    for (uint32_t codePoint = 0x80; codePoint < TwoByteLimit; codePoint++)
+    {
+        if (twoByteCounts[codePoint] > 0)
+        {
+            codePoints.push_back(codePoint);
+        }
+    }
+
+    std::vector<uint32_t> otherCodePoints;
+
+    for (const auto& count : otherCounts)
+    {
+        otherCodePoints.push_back(count.first);
+    }
+
+    std::sort(otherCodePoints.begin(), otherCodePoints.end());
+    codePoints.insert(codePoints.end(), otherCodePoints.begin(), otherCodePoints.end());
+    Assign(codePoints);
+
+    frequencies = byteCounts;
+    frequencies.reserve(Size());
+
+    for (uint32_t codePoint : m_codePoints)
+    {
+        frequencies.push_back((codePoint < TwoByteLimit) ? twoByteCounts[codePoint] : otherCounts[codePoint]);
+    }
+}
+
+const std::vector<uint32_t>& Utf8Alphabet::GetCodePoints() const
+{
+    return m_codePoints;
+}
+
+size_t Utf8Alphabet::Size() const
+{
+    return ByteSymbols + m_codePoints.size();
+}
+
+int Utf8Alphabet::ToUtf8(int symbol, uint8_t* bytes) const
+{
+    if (symbol < ByteSymbols)
+    {
+        bytes[0] = static_cast<uint8_t>(symbol);
+
+        return 1;
+    }
+
+    return EncodeCodePoint(m_codePoints[symbol - ByteSymbols], bytes);
+}
+
+/* Правильная последовательность: верные байты продолжения, без избыточных
+   (overlong) форм, суррогатов и точек больше U+10FFFF */
+int Utf8Alphabet::DecodeCodePoint(const std::string& text, size_t position, uint32_t& codePoint)
+{
+    unsigned char lead = static_cast<unsigned char>(text[position]);
+    int length;
+    uint32_t minimum;
+
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 2;
+        minimum = 0x80;
+        codePoint = lead & 0x1F;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        minimum = 0x800;
+        codePoint = lead & 0x0F;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        minimum = 0x10000;
+        codePoint = lead & 0x07;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (text.size() - position < static_cast<size_t>(length))
+    {
+        return 0;
+    }
+
+    for (int index = 1; index < length; index++)
+    {
+        unsigned char next = static_cast<unsigned char>(text[position + index]);
+
+        if ((next & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+
+        codePoint = (codePoint << 6) | (next & 0x3F);
+    }
+
+    if (codePoint < minimum || codePoint > MaxCodePoint || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+int Utf8Alphabet::EncodeCodePoint(uint32_t codePoint, uint8_t* bytes)
+{
+    if (codePoint < 0x80)
+    {
+        bytes[0] = static_cast<uint8_t>(codePoint);
+
+        return 1;
+    }
+
+    if (codePoint < 0x800)
+    {
+        bytes[0] = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+        bytes[1] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+
+        return 2;
+    }
+
+    if (codePoint < 0x10000)
+    {
+        bytes[0] = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+        bytes[1] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[2] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+
+        return 3;
+    }
+
+    bytes[0] = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+    bytes[1] = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+    bytes[2] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+    bytes[3] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+
+    return 4;
+}
+
+int Utf8Alphabet::FindSymbol(uint32_t codePoint) const
+{
+    if (codePoint < TwoByteLimit)
+    {
+        return m_twoByteSymbols[codePoint];
+    }
+
+    auto found = m_otherSymbols.find(codePoint);
+
+    return (found == m_otherSymbols.end()) ? -1 : found->second;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Алфавит кодовых точек UTF-8.
+   Символы 0..ByteSymbols-1 - отдельные байты: ASCII и байты, которые
+   не входят в правильную последовательность UTF-8 (так кодируется любой
+   вход). Символ ByteSymbols + i - i-я по возрастанию кодовая точка вне
+   ASCII, встретившаяся в тексте. Кириллическая буква становится одним
+   символом вместо двух байтов с почти постоянным первым байтом.
+   Кодовые точки U+0080..U+07FF (двухбайтовые, в том числе кириллица)
+   ищутся в плотной таблице, остальные - в хеш-таблице. */
+class Utf8Alphabet
+{
+public:
+    enum { ByteSymbols = 256, MaxCodePoint = 0x10FFFF, TwoByteLimit = 0x800 };
+
+    Utf8Alphabet();                                                                                     // Конструктор (только байтовые символы)
+
+    bool Assign(const std::vector<uint32_t>& codePoints);                                               // Алфавит по списку точек (false - список неверен)
+
+    void Build(const std::string& text, std::vector<uint64_t>& frequencies);                            // Алфавит текста и частоты его символов
+
+    const std::vector<uint32_t>& GetCodePoints() const;                                                 // Кодовые точки вне ASCII по возрастанию
+
+    size_t Size() const;                                                                                // Число символов алфавита
+
+    int NextSymbol(const std::string& text, size_t& position) const;                                    // Символ с позиции position (ASCII - без поиска)
+
+    int ToUtf8(int symbol, uint8_t* bytes) const;                                                       // Байты символа (до 4), возвращает их число
+
+    static int DecodeCodePoint(const std::string& text, size_t position, uint32_t& codePoint);          // Длина правильной последовательности или 0
+
+    static int EncodeCodePoint(uint32_t codePoint, uint8_t* bytes);                                     // Запись кодовой точки в UTF-8
+
+private:
+    std::vector<uint32_t> m_codePoints;
+    std::vector<int> m_twoByteSymbols;                                                                  // Символ точки U+0080..U+07FF, -1 - нет
+    std::unordered_map<uint32_t, int> m_otherSymbols;                                                   // Символы остальных точек
+
+    int FindSymbol(uint32_t codePoint) const;                                                           // -1 - точки нет в алфавите
+};
+
+/* Быстрый путь: байт ASCII - сам себе символ */
+inline int Utf8Alphabet::NextSymbol(const std::string& text, size_t& position) const
+{
+    unsigned char byte = static_cast<unsigned char>(text[position]);
+
+    if (byte < 0x80)
+    {
+        position++;
+
+        return byte;
+    }
+
+    uint32_t codePoint;
+    int length = DecodeCodePoint(text, position, codePoint);
+    int symbol = (length > 0) ? FindSymbol(codePoint) : -1;
+
+    if (symbol < 0)
+    {
+        position++;
+
+        return byte;
+    }
+
+    position += length;
+
+    return symbol;
+}
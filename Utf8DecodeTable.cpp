@@ -0,0 +1,216 @@
+#include "Utf8DecodeTable.h"
+
+/* Построение таблицы: байты каждого символа, затем записи - первый символ
+   по коду длиной до LookupBits и следующие, пока их коды помещаются
+   в оставшиеся биты индекса, а байты - в запись */
+Utf8DecodeTable::Utf8DecodeTable(const HuffmanTree& tree, const Utf8Alphabet& alphabet)
+    : m_entries(1 << LookupBits, Entry{ { 0, 0, 0, 0 }, 0, 0, 0, 0 }), m_tree(tree.BuildFlatTree())
+{
+    const int tableMask = (1 << LookupBits) - 1;
+    std::vector<HuffmanTree::Code> codeTable = tree.BuildPackedCodeTable();
+    std::vector<int> symbols(1 << LookupBits, -1);
+    std::vector<int> lengths(1 << LookupBits, 0);
+
+    m_symbolBytes.resize(codeTable.size());
+
+    for (int symbol = 0; symbol < static_cast<int>(codeTable.size()); symbol++)
+    {
+        const HuffmanTree::Code& code = codeTable[symbol];
+        SymbolBytes& symbolBytes = m_symbolBytes[symbol];
+        symbolBytes.m_byteCount = static_cast<uint8_t>(alphabet.ToUtf8(symbol, symbolBytes.m_bytes));
+
+        if (code.m_length > 0 && (m_minLength == 0 || code.m_length < m_minLength))
+        {
+            m_minLength = code.m_length;
+        }
+
+        if (code.m_length == 0 || code.m_length > LookupBits)
+        {
+            continue;
+        }
+
+        int first = static_cast<int>(code.m_bits << (LookupBits - code.m_length));
+        int last = first + (1 << (LookupBits - code.m_length));
+
+        for (int index = first; index < last; index++)
+        {
+            symbols[index] = symbol;
+            lengths[index] = code.m_length;
+        }
+    }
+
+    for (int index = 0; index <= tableMask; index++)
+    {
+        Entry& entry = m_entries[index];
+        int used = 0;
+
+        while (true)
+        {
+            int next = (index << used) & tableMask;
+
+            if (symbols[next] < 0 || lengths[next] > LookupBits - used)
+            {
+                break;
+            }
+
+            const SymbolBytes& symbolBytes = m_symbolBytes[symbols[next]];
+
+            if (entry.m_byteCount + symbolBytes.m_byteCount > MaxBytesPerEntry)
+            {
+                break;
+            }
+
+            if (entry.m_byteCount == 0)
+            {
+                entry.m_firstByteCount = symbolBytes.m_byteCount;
+                entry.m_firstBits = static_cast<uint8_t>(lengths[next]);
+            }
+
+            for (int byte = 0; byte < symbolBytes.m_byteCount; byte++)
+            {
+                entry.m_bytes[entry.m_byteCount++] = symbolBytes.m_bytes[byte];
+            }
+
+            used += lengths[next];
+        }
+
+        entry.m_bits = static_cast<uint8_t>(used);
+    }
+}
+
+/* Декодирование byteCount байт. Пока до конца не меньше MaxBytesPerEntry
+   байт, запись копируется целиком: все её символы заканчиваются внутри
+   результата и потому настоящие. Последние байты выводятся по символу.
+   Проверки те же, что у HuffmanDecodeTable: размер до выделения памяти,
+   неверные коды в обходе дерева, чтение за концом данных - один раз
+   в конце. При ошибке результат пуст */
+HuffmanTree::DecodeStatus Utf8DecodeTable::Decode(const uint8_t* data, size_t size, size_t byteCount, std::string& decodedText) const
+{
+    decodedText.clear();
+
+    if (byteCount == 0)
+    {
+        return HuffmanTree::DecodeSuccess;
+    }
+
+    if (m_minLength == 0)
+    {
+        return HuffmanTree::InvalidCode;
+    }
+
+    if (byteCount / MaxBytesPerEntry > size * 8 / m_minLength)
+    {
+        return HuffmanTree::OutputOverrun;
+    }
+
+    decodedText.resize(byteCount + MaxBytesPerEntry);
+    char* output = &decodedText[0];
+    size_t position = 0;
+    BitReader reader(data, size);
+
+    while (position + MaxBytesPerEntry <= byteCount)
+    {
+        reader.Refill();
+        const Entry& entry = m_entries[reader.PeekBits(LookupBits)];
+
+        if (entry.m_byteCount == 0)
+        {
+            int symbol;
+
+            if (!DecodeLongSymbol(reader, symbol))
+            {
+                decodedText.clear();
+
+                return HuffmanTree::InvalidCode;
+            }
+
+            std::memcpy(output + position, m_symbolBytes[symbol].m_bytes, MaxBytesPerEntry);
+            position += m_symbolBytes[symbol].m_byteCount;
+            continue;
+        }
+
+        std::memcpy(output + position, entry.m_bytes, MaxBytesPerEntry);
+        position += entry.m_byteCount;
+        reader.ConsumeBits(entry.m_bits);
+    }
+
+    while (position < byteCount)
+    {
+        reader.Refill();
+        const Entry& entry = m_entries[reader.PeekBits(LookupBits)];
+        const uint8_t* bytes = entry.m_bytes;
+        size_t symbolByteCount = entry.m_firstByteCount;
+
+        if (entry.m_byteCount == 0)
+        {
+            int symbol;
+
+            if (!DecodeLongSymbol(reader, symbol))
+            {
+                decodedText.clear();
+
+                return HuffmanTree::InvalidCode;
+            }
+
+            bytes = m_symbolBytes[symbol].m_bytes;
+            symbolByteCount = m_symbolBytes[symbol].m_byteCount;
+        }
+        else
+        {
+            reader.ConsumeBits(entry.m_firstBits);
+        }
+
+        /* Символ не может выходить за заявленную длину результата */
+        if (position + symbolByteCount > byteCount)
+        {
+            decodedText.clear();
+
+            return HuffmanTree::InvalidCode;
+        }
+
+        std::memcpy(output + position, bytes, MaxBytesPerEntry);
+        position += symbolByteCount;
+    }
+
+    if (reader.IsOverrun())
+    {
+        decodedText.clear();
+
+        return HuffmanTree::TruncatedStream;
+    }
+
+    decodedText.resize(byteCount);
+
+    return HuffmanTree::DecodeSuccess;
+}
+
+/* Обход копии дерева бит за битом. Переход к отсутствующему потомку
+   означает неверный код */
+bool Utf8DecodeTable::DecodeLongSymbol(BitReader& reader, int& symbol) const
+{
+    int node = 0;
+
+    if (m_tree.empty())
+    {
+        return false;
+    }
+
+    while (m_tree[node].m_left >= 0 || m_tree[node].m_right >= 0)
+    {
+        if (reader.BitsAvailable() == 0)
+        {
+            reader.Refill();
+        }
+
+        node = reader.ReadBits(1) ? m_tree[node].m_right : m_tree[node].m_left;
+
+        if (node < 0)
+        {
+            return false;
+        }
+    }
+
+    symbol = m_tree[node].m_symbol;
+
+    return true;
+}
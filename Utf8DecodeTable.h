@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "HuffmanTree.h"
+#include "Utf8Alphabet.h"
+
+/* Табличный декодер для алфавита кодовых точек (Utf8Alphabet).
+   Устроен как HuffmanDecodeTable, но запись хранит не символы, а уже готовые
+   байты UTF-8 - до MaxBytesPerEntry байт нескольких символов, коды которых
+   целиком помещаются в LookupBits битов. Поэтому вывод всегда одно
+   копирование 4 байт: на ASCII за поиск получается до четырёх символов,
+   на кириллице - до двух. Коды длиннее LookupBits и неверные коды
+   декодируются обходом копии дерева. Длина результата задаётся в байтах. */
+class Utf8DecodeTable
+{
+public:
+    static const int LookupBits = 12;
+    static const int MaxBytesPerEntry = 4;
+
+    Utf8DecodeTable(const HuffmanTree& tree, const Utf8Alphabet& alphabet);                             // Построение таблицы по дереву и алфавиту
+
+    HuffmanTree::DecodeStatus Decode(const uint8_t* data, size_t size, size_t byteCount, std::string& decodedText) const;
+
+private:
+    struct Entry
+    {
+        uint8_t m_bytes[MaxBytesPerEntry];
+        uint8_t m_byteCount;                                                                            // 0 - первый код длиннее LookupBits
+        uint8_t m_bits;                                                                                 // Длина всех кодов записи
+        uint8_t m_firstByteCount;                                                                       // Байты и длина кода первого символа
+        uint8_t m_firstBits;
+    };
+
+    struct SymbolBytes                                                                                  // Байты UTF-8 одного символа
+    {
+        uint8_t m_bytes[MaxBytesPerEntry];
+        uint8_t m_byteCount;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<SymbolBytes> m_symbolBytes;
+    std::vector<HuffmanTree::FlatNode> m_tree;
+    int m_minLength = 0;                                                                                // Длина самого короткого кода (0 - кодов нет)
+
+    bool DecodeLongSymbol(BitReader& reader, int& symbol) const;                                        // Обход дерева для длинных и неверных кодов
+};
@@ -0,0 +1,753 @@
+#include "DifferentialCheck.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "HuffmanTree.h"
+#include "HuffmanDecodeTable.h"
+#include "HuffmanStateMachine.h"
+#include "TansCoder.h"
+#include "Lz77Coder.h"
+#include "HuffmanKernels.h"
+#include "CpuFeatures.h"
+#include "HuffmanBlock.h"
+#include "BlockPipeline.h"
+#include "HuffmanStreamCoder.h"
+#include "Crc32c.h"
+#include "FrozenHuffmanTable.h"
+#include "StaticHuffmanCodec.h"
+#include "AdaptiveHuffmanTree.h"
+#include "SemiAdaptiveHuffmanCoder.h"
+
+/* Частоты статического кодека: первые символы с удваивающимися частотами
+   дают коды длиннее HuffmanDecodeTable::LookupBits, так что проверяется
+   и обход дерева для длинных кодов */
+constexpr std::array<int, 256> MakeSkewedFrequencies()
+{
+    std::array<int, 256> frequencies{};
+
+    for (int symbol = 0; symbol < 256; symbol++)
+    {
+        frequencies[symbol] = (symbol < 24) ? (1 << (23 - symbol)) : 1;
+    }
+
+    return frequencies;
+}
+
+constexpr std::array<int, 256> skewedFrequencies = MakeSkewedFrequencies();
+constexpr StaticHuffmanTables skewedTables = BuildStaticHuffmanTables(skewedFrequencies);
+using SkewedCodec = StaticHuffmanCodec<skewedTables>;
+
+static HuffmanTree MakeSkewedTree()
+{
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(std::vector<uint64_t>(skewedFrequencies.begin(), skewedFrequencies.end()));
+
+    return tree;
+}
+
+/* Вырожденные таблицы: у одного символа есть только код "0", у пустого
+   распределения нет кодов - декодер должен отвергать остальные данные */
+constexpr std::array<int, 256> MakeSingleFrequencies()
+{
+    std::array<int, 256> frequencies{};
+    frequencies['a'] = 1;
+
+    return frequencies;
+}
+
+constexpr std::array<int, 256> singleFrequencies = MakeSingleFrequencies();
+constexpr StaticHuffmanTables singleTables = BuildStaticHuffmanTables(singleFrequencies);
+using SingleCodec = StaticHuffmanCodec<singleTables>;
+
+constexpr std::array<int, 256> emptyFrequencies{};
+constexpr StaticHuffmanTables emptyTables = BuildStaticHuffmanTables(emptyFrequencies);
+using EmptyCodec = StaticHuffmanCodec<emptyTables>;
+
+static bool Fail(const char* path, std::string& failure)
+{
+    failure = path;
+
+    return false;
+}
+
+/* Текст кодируется всеми кодерами; результат каждого декодера сравнивается
+   с эталонным обходом дерева, а упакованные биты - с битами дерева */
+bool CheckTextRoundTrip(const std::string& text, std::string& failure)
+{
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(text);
+
+    std::string reference;
+
+    if (tree.Decode(tree.Encode(text).first, reference) != HuffmanTree::DecodeSuccess || reference != text)
+    {
+        return Fail("HuffmanTree::Decode", failure);
+    }
+
+    std::vector<uint8_t> packed = tree.EncodePacked(text).first;
+    std::string decodedText;
+
+    if (tree.DecodePacked(packed, text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+    {
+        return Fail("HuffmanTree::DecodePacked", failure);
+    }
+
+    HuffmanDecodeTable decodeTable(tree);
+
+    if (decodeTable.Decode(packed.data(), packed.size(), text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+    {
+        return Fail("HuffmanDecodeTable::Decode", failure);
+    }
+
+    if (decodeTable.DecodeSingle(packed, text.size()) != reference)
+    {
+        return Fail("HuffmanDecodeTable::DecodeSingle", failure);
+    }
+
+    HuffmanStateMachine stateMachine(tree);
+
+    if (stateMachine.Decode(packed.data(), packed.size(), text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+    {
+        return Fail("HuffmanStateMachine", failure);
+    }
+
+    /* Ядра всех доступных наборов инструкций против простого подсчёта
+       и упаковки кодов по одному */
+    std::vector<uint64_t> frequencies(256, 0);
+    std::vector<HuffmanTree::Code> codeTable = tree.BuildPackedCodeTable();
+    BitWriter writer;
+
+    for (char huffmanChar : text)
+    {
+        frequencies[static_cast<unsigned char>(huffmanChar)]++;
+        writer.WriteBits(codeTable[static_cast<unsigned char>(huffmanChar)].m_bits, codeTable[static_cast<unsigned char>(huffmanChar)].m_length);
+    }
+
+    if (writer.Finish() != packed)
+    {
+        return Fail("HuffmanTree::EncodePacked", failure);
+    }
+
+    if (HuffmanKernels::CountBytes(text) != frequencies)
+    {
+        return Fail("HuffmanKernels::CountBytes", failure);
+    }
+
+    for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Best(); isa++)
+    {
+        CpuFeatures::Isa level = static_cast<CpuFeatures::Isa>(isa);
+        BitWriter kernelWriter;
+        HuffmanKernels::EncodeBytes(level, text.data(), text.size(), codeTable.data(), codeTable.size(), kernelWriter);
+
+        if (kernelWriter.Finish() != packed)
+        {
+            return Fail("HuffmanKernels::EncodeBytes", failure);
+        }
+
+        if (decodeTable.Decode(level, packed.data(), packed.size(), text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+        {
+            return Fail("HuffmanDecodeTable::Decode (набор инструкций)", failure);
+        }
+    }
+
+    /* Чередующиеся потоки, упакованные по одному коду, на всех уровнях */
+    for (int laneCount : { 8, 16 })
+    {
+        std::vector<uint8_t> lanes;
+        std::vector<size_t> laneSizes;
+
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            BitWriter laneWriter;
+
+            for (size_t position = lane; position < text.size(); position += laneCount)
+            {
+                const HuffmanTree::Code& code = codeTable[static_cast<unsigned char>(text[position])];
+                laneWriter.WriteBits(code.m_bits, code.m_length);
+            }
+
+            std::vector<uint8_t> lanePayload = laneWriter.Finish();
+            lanes.insert(lanes.end(), lanePayload.begin(), lanePayload.end());
+            laneSizes.push_back(lanePayload.size());
+        }
+
+        for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Best(); isa++)
+        {
+            if (decodeTable.DecodeInterleaved(static_cast<CpuFeatures::Isa>(isa), lanes.data(), laneSizes, text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+            {
+                return Fail("HuffmanDecodeTable::DecodeInterleaved", failure);
+            }
+        }
+    }
+
+    /* Алфавит до наибольшего байта текста: таблица кодов короче 256 записей,
+       ядра не должны читать за её концом */
+    size_t alphabetSize = 256;
+
+    while (alphabetSize > 0 && frequencies[alphabetSize - 1] == 0)
+    {
+        alphabetSize--;
+    }
+
+    if (alphabetSize > 0)
+    {
+        HuffmanTree smallTree;
+        smallTree.BuildHuffmanTree(std::vector<uint64_t>(frequencies.begin(), frequencies.begin() + alphabetSize));
+        std::vector<uint8_t> smallPacked = smallTree.EncodePacked(text).first;
+
+        if (smallTree.DecodePacked(smallPacked, text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+        {
+            return Fail("HuffmanTree::EncodePacked (малый алфавит)", failure);
+        }
+
+        std::shared_ptr<const FrozenHuffmanTable> smallTable = FrozenHuffmanTable::Create(smallTree);
+
+        if (smallTable->Encode(text) != smallPacked)
+        {
+            return Fail("FrozenHuffmanTable (малый алфавит)", failure);
+        }
+    }
+
+    std::shared_ptr<const FrozenHuffmanTable> frozenTable = FrozenHuffmanTable::Create(tree);
+    std::vector<uint8_t> frozenPacked = frozenTable->Encode(text);
+
+    if (frozenPacked != packed || frozenTable->Decode(frozenPacked, text.size()) != reference)
+    {
+        return Fail("FrozenHuffmanTable", failure);
+    }
+
+    /* Обрезанные данные отличаются от пустого сообщения статусом */
+    if (!text.empty() && frozenTable->Decode(frozenPacked.data(), frozenPacked.size() / 2, text.size(), decodedText) == HuffmanTree::DecodeSuccess)
+    {
+        return Fail("FrozenHuffmanTable (обрезанные данные)", failure);
+    }
+
+    bool exact = false;
+    std::vector<uint64_t> sampled = CompressibilityEstimator().SampleFrequencies(text, exact);
+
+    if (exact != (text.size() < CompressibilityEstimator::SampleSegment * CompressibilityEstimator::SampleStride * 4) || (exact && sampled != HuffmanKernels::CountBytes(text)))
+    {
+        return Fail("CompressibilityEstimator (точная гистограмма)", failure);
+    }
+
+    std::vector<uint8_t> block = HuffmanBlock::Encode(text).first;
+
+    if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+    {
+        return Fail("HuffmanBlock", failure);
+    }
+
+    block = HuffmanBlock::EncodeStored(text).first;
+
+    if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+    {
+        return Fail("HuffmanBlock::EncodeStored", failure);
+    }
+
+    block = HuffmanBlock::Encode(text, CompressibilityEstimator(), true).first;
+
+    if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+    {
+        return Fail("HuffmanBlock (CRC32C)", failure);
+    }
+
+    block = HuffmanBlock::EncodeStored(text, true).first;
+
+    if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+    {
+        return Fail("HuffmanBlock::EncodeStored (CRC32C)", failure);
+    }
+
+    for (bool checksum : { false, true })
+    {
+        block = HuffmanBlock::EncodeUtf8(text, checksum).first;
+
+        if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+        {
+            return Fail(checksum ? "HuffmanBlock::EncodeUtf8 (CRC32C)" : "HuffmanBlock::EncodeUtf8", failure);
+        }
+
+        block = HuffmanBlock::EncodeTans(text, checksum).first;
+
+        if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+        {
+            return Fail(checksum ? "HuffmanBlock::EncodeTans (CRC32C)" : "HuffmanBlock::EncodeTans", failure);
+        }
+
+        /* LZ77: наименьшее окно с быстрым уровнем, параметры по умолчанию,
+           наибольшее окно с самым тщательным уровнем */
+        const int lzParameters[][2] = { { Lz77Coder::MinWindowBits, Lz77Coder::MinLevel }, { Lz77Coder::DefaultWindowBits, Lz77Coder::DefaultLevel }, { Lz77Coder::MaxWindowBits, Lz77Coder::MaxLevel } };
+
+        for (const int* parameters : lzParameters)
+        {
+            block = HuffmanBlock::EncodeLz(text, parameters[0], parameters[1], checksum).first;
+
+            if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+            {
+                return Fail(checksum ? "HuffmanBlock::EncodeLz (CRC32C)" : "HuffmanBlock::EncodeLz", failure);
+            }
+        }
+
+        for (int laneCount : { 8, 16 })
+        {
+            block = HuffmanBlock::EncodeInterleaved(text, laneCount, checksum).first;
+
+            if (!HuffmanBlock::Decode(block, decodedText) || decodedText != reference)
+            {
+                return Fail(checksum ? "HuffmanBlock::EncodeInterleaved (CRC32C)" : "HuffmanBlock::EncodeInterleaved", failure);
+            }
+        }
+    }
+
+    /* tANS на крайних размерах таблицы */
+    for (int tableLog : { TansCoder::MinTableLog, TansCoder::DefaultTableLog, TansCoder::MaxTableLog })
+    {
+        std::vector<int> counts = TansCoder::NormalizeCounts(frequencies, tableLog);
+
+        if (counts.empty())
+        {
+            continue;
+        }
+
+        TansCoder tansCoder(counts, tableLog);
+        BitWriter tansWriter;
+        tansCoder.Encode(text.data(), text.size(), tansWriter);
+        std::vector<uint8_t> tansPacked = tansWriter.Finish();
+
+        if (!TansCoder::CheckCounts(counts, tableLog) || tansCoder.Decode(tansPacked.data(), tansPacked.size(), text.size(), decodedText) != HuffmanTree::DecodeSuccess || decodedText != reference)
+        {
+            return Fail("TansCoder", failure);
+        }
+    }
+
+    /* Разбор LZ77 сам по себе: совпадения в пределах окна и уже
+       восстановленного текста, копирование по байту воспроизводит текст */
+    for (int level = Lz77Coder::MinLevel; level <= Lz77Coder::MaxLevel; level += 4)
+    {
+        Lz77Coder lzCoder(Lz77Coder::MinWindowBits, level);
+        std::string rebuilt;
+
+        for (const Lz77Coder::Token& token : lzCoder.Parse(text))
+        {
+            if (token.m_length == 0)
+            {
+                rebuilt.push_back(static_cast<char>(token.m_literal));
+                continue;
+            }
+
+            if (token.m_length < Lz77Coder::MinMatch || token.m_length > Lz77Coder::MaxMatch || token.m_distance == 0 || token.m_distance > rebuilt.size() || token.m_distance >= (1u << Lz77Coder::MinWindowBits))
+            {
+                return Fail("Lz77Coder::Parse", failure);
+            }
+
+            for (size_t copied = 0; copied < token.m_length; copied++)
+            {
+                rebuilt.push_back(rebuilt[rebuilt.size() - token.m_distance]);
+            }
+        }
+
+        if (rebuilt != reference)
+        {
+            return Fail("Lz77Coder::Parse", failure);
+        }
+    }
+
+    if (Crc32c::CalculateSliced(text.data(), text.size()) != Crc32c::Calculate(text.data(), text.size()))
+    {
+        return Fail("Crc32c", failure);
+    }
+
+    std::string staticText;
+
+    std::vector<uint8_t> staticData;
+
+    if (!SkewedCodec::Encode(text, staticData) || SkewedCodec::Decode(staticData, text.size(), staticText) != HuffmanTree::DecodeSuccess || staticText != reference)
+    {
+        return Fail("StaticHuffmanCodec", failure);
+    }
+
+    /* В таблицах одного символа кода есть только у 'a' */
+    if (SingleCodec::Encode(text, staticData) != (text.find_first_not_of('a') == std::string::npos))
+    {
+        return Fail("StaticHuffmanCodec::Encode (символ без кода)", failure);
+    }
+
+    AdaptiveHuffmanTree adaptiveEncoder;
+    AdaptiveHuffmanTree adaptiveDecoder;
+    std::string adaptiveBits = adaptiveEncoder.Encode(text);
+    std::string adaptiveText;
+
+    if (adaptiveDecoder.Decode(adaptiveBits, adaptiveText) != HuffmanTree::DecodeSuccess || adaptiveText != reference)
+    {
+        return Fail("AdaptiveHuffmanTree", failure);
+    }
+
+    /* Знак не '0' и не '1' посреди потока - неверный код */
+    if (!adaptiveBits.empty())
+    {
+        adaptiveBits[adaptiveBits.size() / 2] = '2';
+        adaptiveDecoder.Reset();
+
+        if (adaptiveDecoder.Decode(adaptiveBits, adaptiveText) != HuffmanTree::InvalidCode)
+        {
+            return Fail("AdaptiveHuffmanTree (неверный знак)", failure);
+        }
+    }
+
+    /* Короткий интервал, чтобы таблица успела перестроиться */
+    SemiAdaptiveHuffmanCoder semiAdaptiveEncoder(64);
+    SemiAdaptiveHuffmanCoder semiAdaptiveDecoder(64);
+    std::vector<uint8_t> semiAdaptiveData = semiAdaptiveEncoder.Encode(text);
+    std::string semiAdaptiveText;
+
+    if (semiAdaptiveDecoder.Decode(semiAdaptiveData, text.size(), semiAdaptiveText) != HuffmanTree::DecodeSuccess || semiAdaptiveText != reference)
+    {
+        return Fail("SemiAdaptiveHuffmanCoder", failure);
+    }
+
+    /* На начале текста: порции, разрезанные посреди интервала, дают тот же
+       поток, а сдвиги затухания вне 1..63 ограничиваются */
+    std::string prefix = text.substr(0, 1000);
+    SemiAdaptiveHuffmanCoder chunkedEncoder(64);
+    BitWriter chunkedWriter;
+
+    for (size_t position = 0; position < prefix.size(); position += 100)
+    {
+        chunkedEncoder.Encode(prefix.substr(position, 100), chunkedWriter);
+    }
+
+    std::vector<uint8_t> prefixData = SemiAdaptiveHuffmanCoder(64).Encode(prefix);
+
+    if (chunkedWriter.Finish() != prefixData)
+    {
+        return Fail("SemiAdaptiveHuffmanCoder (порции)", failure);
+    }
+
+    if (SemiAdaptiveHuffmanCoder(64, 0).Encode(prefix) != prefixData || SemiAdaptiveHuffmanCoder(64, 64).Encode(prefix) != SemiAdaptiveHuffmanCoder(64, 63).Encode(prefix))
+    {
+        return Fail("SemiAdaptiveHuffmanCoder (сдвиг затухания)", failure);
+    }
+
+    return true;
+}
+
+/* Недоверенные данные. Сначала весь вход разбирается как блок: декодер
+   может отказаться, но не должен падать. Затем из входа берутся длины кодов
+   (возможно, неполные или нарушающие неравенство Крафта) и данные: табличный
+   декодер должен принять вход тогда и только тогда, когда его принимает
+   обход дерева, и выдать тот же текст.
+
+       байт 0        число длин кодов (1..64)
+       байт 1        делитель числа символов
+       далее         длины кодов (по модулю 20), затем данные */
+bool CheckUntrustedDecode(const uint8_t* data, size_t size, std::string& failure)
+{
+    std::string decodedText;
+    HuffmanBlock::Decode(std::vector<uint8_t>(data, data + size), decodedText);
+
+    if (size < 2)
+    {
+        return true;
+    }
+
+    size_t lengthCount = std::min<size_t>(1 + data[0] % 64, size - 2);
+    std::vector<int> codeLengths(lengthCount);
+
+    for (size_t symbol = 0; symbol < lengthCount; symbol++)
+    {
+        codeLengths[symbol] = data[2 + symbol] % 20;
+    }
+
+    std::vector<uint8_t> payload(data + 2 + lengthCount, data + size);
+    size_t symbolCount = payload.size() * 8 / (1 + data[1] % 8);
+
+    /* Статический кодек: вырожденные таблицы и обрезанные данные */
+    if (SingleCodec::Decode(payload, symbolCount, decodedText) == HuffmanTree::DecodeSuccess && decodedText != std::string(symbolCount, 'a'))
+    {
+        return Fail("StaticHuffmanCodec (один символ)", failure);
+    }
+
+    if (symbolCount > 0 && EmptyCodec::Decode(payload, symbolCount, decodedText) == HuffmanTree::DecodeSuccess)
+    {
+        return Fail("StaticHuffmanCodec (пустое дерево)", failure);
+    }
+
+    /* Число символов не из данных: больше, чем помещается в них, и такое,
+       что с запасом декодера переполняет size_t */
+    for (size_t oversized : { payload.size() * 8 + 1, SIZE_MAX })
+    {
+        if (SingleCodec::Decode(payload, oversized, decodedText) != HuffmanTree::OutputOverrun || SkewedCodec::Decode(payload, oversized, decodedText) != HuffmanTree::OutputOverrun)
+        {
+            return Fail("StaticHuffmanCodec (число символов больше данных)", failure);
+        }
+    }
+
+    /* Полуадаптивный декодер: произвольные коды и бит смены таблицы. Таблица
+       декодера перестраивается по каждому биту 1, поэтому бит один */
+    SemiAdaptiveHuffmanCoder semiAdaptiveDecoder(256);
+    semiAdaptiveDecoder.Decode(payload, std::min<size_t>(symbolCount, 512), decodedText);
+
+    if (semiAdaptiveDecoder.Decode(payload, SIZE_MAX, decodedText) != HuffmanTree::OutputOverrun)
+    {
+        return Fail("SemiAdaptiveHuffmanCoder (число символов больше данных)", failure);
+    }
+
+    /* Коды статических таблиц совпадают с деревом по тем же частотам,
+       поэтому эталон - обход дерева (на первых символах: обход медленный) */
+    static const HuffmanTree skewedTree = MakeSkewedTree();
+    size_t skewedCount = std::min<size_t>(symbolCount, 256);
+    std::string skewedReference;
+    HuffmanTree::DecodeStatus skewedStatus = skewedTree.DecodePacked(payload, skewedCount, skewedReference);
+
+    if ((SkewedCodec::Decode(payload, skewedCount, decodedText) == HuffmanTree::DecodeSuccess) != (skewedStatus == HuffmanTree::DecodeSuccess)
+        || (skewedStatus == HuffmanTree::DecodeSuccess && decodedText != skewedReference))
+    {
+        return Fail("StaticHuffmanCodec (недоверенные данные)", failure);
+    }
+
+    HuffmanTree tree;
+
+    if (!tree.BuildFromCodeLengths(codeLengths))
+    {
+        return true;
+    }
+
+    std::string reference;
+    HuffmanTree::DecodeStatus referenceStatus = tree.DecodePacked(payload, symbolCount, reference);
+
+    HuffmanDecodeTable decodeTable(tree);
+
+    for (int isa = CpuFeatures::Scalar; isa <= CpuFeatures::Best(); isa++)
+    {
+        HuffmanTree::DecodeStatus status = decodeTable.Decode(static_cast<CpuFeatures::Isa>(isa), payload.data(), payload.size(), symbolCount, decodedText);
+
+        if ((status == HuffmanTree::DecodeSuccess) != (referenceStatus == HuffmanTree::DecodeSuccess))
+        {
+            return Fail("HuffmanDecodeTable::Decode (статус)", failure);
+        }
+
+        if (status == HuffmanTree::DecodeSuccess && decodedText != reference)
+        {
+            return Fail("HuffmanDecodeTable::Decode (недоверенные данные)", failure);
+        }
+    }
+
+    HuffmanStateMachine stateMachine(tree);
+    HuffmanTree::DecodeStatus status = stateMachine.Decode(payload.data(), payload.size(), symbolCount, decodedText);
+
+    if ((status == HuffmanTree::DecodeSuccess) != (referenceStatus == HuffmanTree::DecodeSuccess) || (status == HuffmanTree::DecodeSuccess && decodedText != reference))
+    {
+        return Fail("HuffmanStateMachine (недоверенные данные)", failure);
+    }
+
+    /* Те же данные, разделённые на 8 потоков: все уровни должны совпасть
+       с переносимым декодером. Вид ошибки может отличаться - потоки
+       проверяются в разном порядке */
+    std::vector<size_t> laneSizes(8, payload.size() / 8);
+    laneSizes[7] += payload.size() % 8;
+    std::string scalarText;
+    HuffmanTree::DecodeStatus scalarStatus = decodeTable.DecodeInterleaved(CpuFeatures::Scalar, payload.data(), laneSizes, symbolCount, scalarText);
+
+    for (int isa = CpuFeatures::Scalar + 1; isa <= CpuFeatures::Best(); isa++)
+    {
+        HuffmanTree::DecodeStatus status = decodeTable.DecodeInterleaved(static_cast<CpuFeatures::Isa>(isa), payload.data(), laneSizes, symbolCount, decodedText);
+
+        if ((status == HuffmanTree::DecodeSuccess) != (scalarStatus == HuffmanTree::DecodeSuccess) || decodedText != scalarText)
+        {
+            return Fail("HuffmanDecodeTable::DecodeInterleaved (недоверенные данные)", failure);
+        }
+    }
+
+    return true;
+}
+
+/* Повреждённый блок с контрольной суммой: декодер может принять его,
+   только если результат совпал с исходным текстом */
+bool CheckCorruptedBlock(const std::vector<uint8_t>& block, const std::string& text, std::string& failure)
+{
+    std::string decodedText;
+
+    if (HuffmanBlock::HasChecksum(block) && HuffmanBlock::Decode(block, decodedText) && decodedText != text)
+    {
+        return Fail("HuffmanBlock (повреждение не обнаружено)", failure);
+    }
+
+    return CheckUntrustedDecode(block.data(), block.size(), failure);
+}
+
+/* Потоки кодируют и декодируют свои части текста одной замороженной
+   таблицей; каждая часть сравнивается с обходом дерева */
+bool CheckParallelDecode(const std::string& text, unsigned threadCount, std::string& failure)
+{
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(text);
+    std::shared_ptr<const FrozenHuffmanTable> frozenTable = FrozenHuffmanTable::Create(tree);
+
+    size_t chunkSize = text.size() / threadCount + 1;
+    std::vector<char> results(threadCount, 0);
+    std::vector<std::thread> workers;
+
+    for (unsigned worker = 0; worker < threadCount; worker++)
+    {
+        workers.emplace_back([&, worker]()
+            {
+                std::string chunk = text.substr(std::min(text.size(), worker * chunkSize), chunkSize);
+                std::vector<uint8_t> packed = frozenTable->Encode(chunk);
+                std::string reference;
+
+                std::string decodedChunk;
+
+                results[worker] = tree.DecodePacked(packed, chunk.size(), reference) == HuffmanTree::DecodeSuccess && reference == chunk &&
+                    frozenTable->Decode(packed.data(), packed.size(), chunk.size(), decodedChunk) == HuffmanTree::DecodeSuccess && decodedChunk == reference;
+            });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (std::find(results.begin(), results.end(), 0) != results.end())
+    {
+        return Fail("FrozenHuffmanTable (потоки)", failure);
+    }
+
+    return true;
+}
+
+/* Мелкие блоки, чтобы в конвейере одновременно было много заданий
+   и писателю приходилось восстанавливать порядок */
+bool CheckPipelineRoundTrip(const std::string& text, unsigned workerCount, std::string& failure)
+{
+    BlockPipeline pipeline(1000, workerCount);
+    std::istringstream input(text);
+    std::stringstream encoded;
+    std::ostringstream decoded;
+
+    if (!pipeline.Compress(input, encoded) || !pipeline.Decompress(encoded, decoded) || decoded.str() != text)
+    {
+        return Fail("BlockPipeline", failure);
+    }
+
+    return true;
+}
+
+/* Поток одной таблицей; с sampleBlockSize > 0 таблица строится по выборке,
+   и байты вне неё кодируются через escape */
+bool CheckStreamRoundTrip(const std::string& text, size_t segmentSize, size_t sampleBlockSize, std::string& failure)
+{
+    HuffmanStreamCoder coder(segmentSize, sampleBlockSize);
+    std::istringstream input(text);
+    std::stringstream encoded;
+    std::ostringstream decoded;
+
+    if (!coder.Compress(input, encoded) || !coder.Decompress(encoded, decoded) || decoded.str() != text)
+    {
+        return Fail(sampleBlockSize ? "HuffmanStreamCoder (выборка)" : "HuffmanStreamCoder", failure);
+    }
+
+    /* Повреждённая контрольная сумма в конце потока */
+    std::string corrupted = encoded.str();
+    corrupted.back() ^= 1;
+    std::istringstream corruptedInput(corrupted);
+    std::ostringstream ignored;
+
+    if (coder.Decompress(corruptedInput, ignored))
+    {
+        return Fail("HuffmanStreamCoder (CRC32C)", failure);
+    }
+
+    return true;
+}
+
+/* Гистограмма с 64-битными счётчиками: после масштабирования дерево должно
+   давать полный код, который помещается в BitWriter */
+bool CheckScaledFrequencies(const std::vector<uint64_t>& frequencies, std::string& failure)
+{
+    std::vector<uint64_t> scaled = HuffmanTree::ScaleFrequencies(frequencies, HuffmanStreamCoder::MaxScaledTotal);
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(scaled);
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+
+    for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
+    {
+        if ((frequencies[symbol] > 0) != (codeLengths[symbol] > 0) || codeLengths[symbol] > BitWriter::MaxWriteBits)
+        {
+            return Fail("HuffmanTree::ScaleFrequencies", failure);
+        }
+    }
+
+    bool empty = std::all_of(frequencies.begin(), frequencies.end(), [](uint64_t frequency) { return frequency == 0; });
+
+    if (!empty && !HuffmanTree::CheckKraft(codeLengths, true))
+    {
+        return Fail("HuffmanTree::ScaleFrequencies (Kraft)", failure);
+    }
+
+    return true;
+}
+
+/* Коды и длины, построенные при компиляции, и дерево HuffmanTree
+   по тем же частотам */
+static bool MatchesTree(const StaticHuffmanTables& tables, const std::array<int, 256>& frequencies)
+{
+    HuffmanTree tree;
+    tree.BuildHuffmanTree(std::vector<uint64_t>(frequencies.begin(), frequencies.end()));
+    std::vector<int> codeLengths = tree.BuildCodeLengths();
+    std::vector<HuffmanTree::Code> codes = tree.BuildPackedCodeTable();
+
+    for (int symbol = 0; symbol < StaticHuffmanTables::AlphabetSize; symbol++)
+    {
+        if (tables.m_lengths[symbol] != codeLengths[symbol] || (codeLengths[symbol] > 0 && tables.m_codes[symbol] != codes[symbol].m_bits))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+constexpr std::array<int, 256> MakeFibonacciFrequencies()
+{
+    std::array<int, 256> frequencies{};
+    frequencies[0] = frequencies[1] = 1;
+
+    for (int symbol = 2; symbol < 40; symbol++)
+    {
+        frequencies[symbol] = frequencies[symbol - 1] + frequencies[symbol - 2];
+    }
+
+    return frequencies;
+}
+
+constexpr std::array<int, 256> MakeUniformFrequencies()
+{
+    std::array<int, 256> frequencies{};
+
+    for (int& frequency : frequencies)
+    {
+        frequency = 1;
+    }
+
+    return frequencies;
+}
+
+constexpr std::array<int, 256> fibonacciFrequencies = MakeFibonacciFrequencies();
+constexpr StaticHuffmanTables fibonacciTables = BuildStaticHuffmanTables(fibonacciFrequencies);
+constexpr std::array<int, 256> uniformFrequencies = MakeUniformFrequencies();
+constexpr StaticHuffmanTables uniformTables = BuildStaticHuffmanTables(uniformFrequencies);
+
+bool CheckStaticTables(std::string& failure)
+{
+    if (!MatchesTree(skewedTables, skewedFrequencies) || !MatchesTree(singleTables, singleFrequencies) || !MatchesTree(fibonacciTables, fibonacciFrequencies)
+        || !MatchesTree(uniformTables, uniformFrequencies))
+    {
+        return Fail("BuildStaticHuffmanTables", failure);
+    }
+
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Дифференциальные проверки кодеков. Эталон - обход дерева HuffmanTree
+   (Decode по строке битов и DecodePacked); каждый быстрый путь должен
+   выдавать тот же результат. Проверки общие для фаззера (HuffmanFuzzer.cpp)
+   и генератора распределений (DifferentialTest.cpp). При расхождении
+   возвращается false, а в failure - название пути, который разошёлся. */
+
+bool CheckTextRoundTrip(const std::string& text, std::string& failure);                                 // Все кодеры и декодеры на одном тексте
+
+bool CheckUntrustedDecode(const uint8_t* data, size_t size, std::string& failure);                      // Произвольные длины кодов и данные
+
+bool CheckCorruptedBlock(const std::vector<uint8_t>& block, const std::string& text, std::string& failure);
+
+bool CheckParallelDecode(const std::string& text, unsigned threadCount, std::string& failure);          // Общая таблица из нескольких потоков
+
+bool CheckPipelineRoundTrip(const std::string& text, unsigned workerCount, std::string& failure);       // Конвейер с мелкими блоками
+
+bool CheckStreamRoundTrip(const std::string& text, size_t segmentSize, size_t sampleBlockSize, std::string& failure);
+
+bool CheckScaledFrequencies(const std::vector<uint64_t>& frequencies, std::string& failure);            // Длины кодов после масштабирования
+
+bool CheckStaticTables(std::string& failure);                                                           // Таблицы при компиляции и HuffmanTree
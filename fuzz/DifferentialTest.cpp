@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DifferentialCheck.h"
+#include "HuffmanBlock.h"
+#include "Lz77Coder.h"
+
+/* Генератор псевдослучайных чисел: воспроизводимые входы без зависимостей */
+class Random
+{
+public:
+    explicit Random(uint32_t seed)                                                                      // Конструктор
+        : m_state(seed)
+    {
+    }
+
+    uint32_t Next()
+    {
+        m_state = m_state * 1664525 + 1013904223;
+
+        return m_state >> 8;
+    }
+
+private:
+    uint32_t m_state;
+};
+
+/* Распределение символов: по генератору и длине строит текст */
+struct Distribution
+{
+    const char* m_name;
+    std::function<std::string(Random&, size_t)> m_generate;
+};
+
+static std::vector<Distribution> MakeDistributions()
+{
+    std::vector<Distribution> distributions;
+
+    distributions.push_back({ "равномерное", [](Random& random, size_t size)
+        {
+            std::string text(size, '\0');
+
+            for (char& huffmanChar : text)
+            {
+                huffmanChar = static_cast<char>(random.Next());
+            }
+
+            return text;
+        } });
+
+    /* Номер символа - число нулевых младших битов: вероятности 1/2, 1/4, ... */
+    distributions.push_back({ "геометрическое", [](Random& random, size_t size)
+        {
+            std::string text(size, '\0');
+
+            for (char& huffmanChar : text)
+            {
+                huffmanChar = static_cast<char>('a' + __builtin_ctz(random.Next() | (1u << 23)));
+            }
+
+            return text;
+        } });
+
+    distributions.push_back({ "один символ", [](Random& random, size_t size)
+        {
+            return std::string(size, static_cast<char>(random.Next()));
+        } });
+
+    distributions.push_back({ "два символа", [](Random& random, size_t size)
+        {
+            std::string text(size, '\0');
+
+            for (char& huffmanChar : text)
+            {
+                huffmanChar = (random.Next() % 100 == 0) ? '\xff' : '\0';
+            }
+
+            return text;
+        } });
+
+    /* Частоты - числа Фибоначчи: вырожденное дерево с кодами длиннее
+       таблицы декодера */
+    distributions.push_back({ "Фибоначчи", [](Random& random, size_t size)
+        {
+            std::vector<size_t> counts = { 1, 1 };
+
+            while (counts.size() < 26)
+            {
+                counts.push_back(counts[counts.size() - 1] + counts[counts.size() - 2]);
+            }
+
+            std::string text;
+
+            for (size_t symbol = 0; symbol < counts.size() && text.size() < size; symbol++)
+            {
+                text.append(std::min(counts[symbol], size - text.size()), static_cast<char>(symbol * 7));
+            }
+
+            for (size_t position = text.size(); position > 1; position--)
+            {
+                std::swap(text[position - 1], text[random.Next() % position]);
+            }
+
+            return text;
+        } });
+
+    /* Смешанный UTF-8: ASCII, кириллица, четырёхбайтовые символы
+       и неправильные байты */
+    distributions.push_back({ "UTF-8", [](Random& random, size_t size)
+        {
+            static const char* const pieces[] = { " ", "a", "о", "е", "и", "Ж", "\xF0\x9F\x98\x80", "\xD0", "\xFF" };
+            static const int weights[] = { 8, 3, 10, 8, 6, 1, 1, 1, 1 };
+            std::string text;
+
+            while (text.size() < size)
+            {
+                uint32_t pick = random.Next() % 39;
+                int piece = 0;
+
+                while (pick >= static_cast<uint32_t>(weights[piece]))
+                {
+                    pick -= weights[piece++];
+                }
+
+                text += pieces[piece];
+            }
+
+            text.resize(size);
+
+            return text;
+        } });
+
+    /* Повторы: копии уже написанных кусков на близких и далёких
+       расстояниях (в том числе перекрывающиеся) вперемешку со случайными
+       буквами - на таком тексте LZ77 находит совпадения */
+    distributions.push_back({ "повторы", [](Random& random, size_t size)
+        {
+            std::string text;
+
+            while (text.size() < size)
+            {
+                if (text.empty() || random.Next() % 4 == 0)
+                {
+                    text.push_back(static_cast<char>('a' + random.Next() % 16));
+                    continue;
+                }
+
+                size_t distance = 1 + ((random.Next() % 2) ? random.Next() % 16 : random.Next() % text.size()) % text.size();
+                size_t length = 3 + random.Next() % ((random.Next() % 8 == 0) ? 300 : 20);
+
+                for (size_t copied = 0; copied < length; copied++)
+                {
+                    text.push_back(text[text.size() - distance]);
+                }
+            }
+
+            text.resize(size);
+
+            return text;
+        } });
+
+    distributions.push_back({ "все байты", [](Random& random, size_t size)
+        {
+            std::string text(size, '\0');
+            uint32_t shift = random.Next();
+
+            for (size_t position = 0; position < size; position++)
+            {
+                text[position] = static_cast<char>(position + shift);
+            }
+
+            return text;
+        } });
+
+    return distributions;
+}
+
+/* Дифференциальная проверка: все пути кодирования и декодирования сравниваются
+   с обходом дерева на случайных и вырожденных распределениях, а декодеры -
+   на повреждённых блоках и произвольных байтах */
+int main()
+{
+    const size_t sizes[] = { 0, 1, 2, 3, 7, 64, 1000, 4097, 65536 };
+    Random random(1);
+    size_t checkCount = 0;
+    size_t failureCount = 0;
+    std::string failure;
+
+    auto report = [&](bool passed, const char* name, size_t size)
+        {
+            checkCount++;
+
+            if (!passed)
+            {
+                failureCount++;
+                std::cout << "Расхождение: " << failure << " (" << name << ", " << size << " символов)" << std::endl;
+            }
+        };
+
+    for (const Distribution& distribution : MakeDistributions())
+    {
+        for (size_t size : sizes)
+        {
+            std::string text = distribution.m_generate(random, size);
+            report(CheckTextRoundTrip(text, failure), distribution.m_name, size);
+            report(CheckParallelDecode(text, 4, failure), distribution.m_name, size);
+            report(CheckPipelineRoundTrip(text, 3, failure), distribution.m_name, size);
+            report(CheckStreamRoundTrip(text, 1000, 0, failure), distribution.m_name, size);
+            report(CheckStreamRoundTrip(text, 1000, 64, failure), distribution.m_name, size);
+
+            /* Повреждённые байтовые, UTF-8, чередующиеся, tANS и LZ77 блоки
+               с контрольной суммой и без: инвертированный бит и обрезанный конец */
+            for (bool checksum : { false, true })
+            {
+                std::vector<uint8_t> blocks[] = { HuffmanBlock::Encode(text, CompressibilityEstimator(), checksum).first, HuffmanBlock::EncodeUtf8(text, checksum).first,
+                    HuffmanBlock::EncodeInterleaved(text, 8, checksum).first, HuffmanBlock::EncodeTans(text, checksum).first,
+                    HuffmanBlock::EncodeLz(text, Lz77Coder::MinWindowBits, Lz77Coder::DefaultLevel, checksum).first };
+
+                for (int mutation = 0; mutation < 160; mutation++)
+                {
+                    const std::vector<uint8_t>& block = blocks[mutation % 5];
+                    std::vector<uint8_t> corrupted = block;
+                    corrupted[random.Next() % corrupted.size()] ^= static_cast<uint8_t>(1 << (random.Next() % 8));
+                    corrupted.resize(corrupted.size() - random.Next() % 2 * (random.Next() % corrupted.size()));
+
+                    report(CheckCorruptedBlock(corrupted, text, failure), distribution.m_name, size);
+                }
+            }
+        }
+    }
+
+    report(CheckStaticTables(failure), "статические таблицы", 256);
+
+    /* Счётчики больше 2^32: числа Фибоначчи (самое глубокое дерево)
+       и случайные гистограммы с сильно различающимися частотами */
+    std::vector<uint64_t> fibonacci(256, 0);
+    fibonacci[0] = fibonacci[1] = 1;
+
+    for (size_t symbol = 2; symbol < 90; symbol++)
+    {
+        fibonacci[symbol] = fibonacci[symbol - 1] + fibonacci[symbol - 2];
+    }
+
+    report(CheckScaledFrequencies(fibonacci, failure), "Фибоначчи, 64 бита", 90);
+
+    for (int histogram = 0; histogram < 1000; histogram++)
+    {
+        std::vector<uint64_t> frequencies(1 + random.Next() % 256);
+
+        for (uint64_t& frequency : frequencies)
+        {
+            frequency = ((static_cast<uint64_t>(random.Next()) << 32) | random.Next()) >> (8 + random.Next() % 56);
+        }
+
+        report(CheckScaledFrequencies(frequencies, failure), "64-битная гистограмма", frequencies.size());
+    }
+
+    for (int input = 0; input < 20000; input++)
+    {
+        std::vector<uint8_t> data(random.Next() % 300);
+
+        for (uint8_t& byte : data)
+        {
+            byte = static_cast<uint8_t>(random.Next());
+        }
+
+        report(CheckUntrustedDecode(data.data(), data.size(), failure), "произвольные байты", data.size());
+    }
+
+    std::cout << "Проверок: " << checkCount << ", расхождений: " << failureCount << std::endl;
+
+    return failureCount == 0 ? 0 : 1;
+}
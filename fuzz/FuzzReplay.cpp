@@ -0,0 +1,32 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/* Запуск фаззера без libFuzzer: каждый файл из аргументов подаётся
+   на вход LLVMFuzzerTestOneInput. Нужен для воспроизведения найденных
+   входов компилятором без -fsanitize=fuzzer */
+int main(int argc, char* argv[])
+{
+    for (int argument = 1; argument < argc; argument++)
+    {
+        std::ifstream input(argv[argument], std::ios::binary);
+
+        if (!input)
+        {
+            std::cerr << "Не удалось открыть " << argv[argument] << std::endl;
+
+            return 1;
+        }
+
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+
+    std::cout << "Входов: " << argc - 1 << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "DifferentialCheck.h"
+
+/* Точка входа libFuzzer: вход проверяется и как текст для всех кодеков,
+   и как недоверенные данные для декодеров. Расхождение - аварийный выход,
+   чтобы libFuzzer сохранил вход */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    std::string text(reinterpret_cast<const char*>(data), size);
+    std::string failure;
+
+    if (!CheckTextRoundTrip(text, failure) || !CheckUntrustedDecode(data, size, failure))
+    {
+        std::cerr << "Расхождение: " << failure << std::endl;
+        std::abort();
+    }
+
+    return 0;
+}
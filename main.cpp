@@ -1,237 +1,578 @@
 #include <iostream>
-#include <list>
-#include <vector>
-#include <map>
-#include <unordered_map>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+#include "HuffmanTree.h"
+#include "HuffmanDecodeTable.h"
+#include "HuffmanStateMachine.h"
+#include "HuffmanKernels.h"
+#include "CpuFeatures.h"
+#include "StaticHuffmanCodec.h"
+#include "HuffmanBlock.h"
+#include "Lz77Coder.h"
+#include "BlockPipeline.h"
+#include "HuffmanStreamCoder.h"
+#include "Crc32c.h"
+#include "FrozenHuffmanTable.h"
+#include "AdaptiveHuffmanTree.h"
+#include "SemiAdaptiveHuffmanCoder.h"
+
+/* Общая таблица: потоки кодируют и декодируют свои части текста одной
+   замороженной таблицей без блокировок */
+int RunShared(const std::string& text)
+{
+    HuffmanTree builder;
+    builder.BuildHuffmanTree(text);
+    std::shared_ptr<const FrozenHuffmanTable> table = FrozenHuffmanTable::Create(builder);
+
+    unsigned threadCount = std::max(4u, std::thread::hardware_concurrency());
+    size_t chunkSize = text.size() / threadCount + 1;
+    std::atomic<bool> success(true);
+    std::vector<std::thread> workers;
+
+    for (unsigned worker = 0; worker < threadCount; worker++)
+    {
+        workers.emplace_back([table, &text, &success, worker, chunkSize]()
+            {
+                std::string chunk = text.substr(std::min(text.size(), worker * chunkSize), chunkSize);
+                std::string decodedChunk;
+
+                for (int repeat = 0; repeat < 100; repeat++)
+                {
+                    std::vector<uint8_t> encodedChunk = table->Encode(chunk);
+
+                    if (table->Decode(encodedChunk.data(), encodedChunk.size(), chunk.size(), decodedChunk) != HuffmanTree::DecodeSuccess || decodedChunk != chunk)
+                    {
+                        success = false;
+                    }
+                }
+            });
+    }
 
-class HuffmanTree
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::cout << "Потоков: " << threadCount << std::endl;
+    std::cout << "Декодирование прошло " << (success ? "успешно" : "неудачно") << std::endl;
+
+    return 0;
+}
+
+/* Конвейер: input.txt сжимается в encoded.bin и распаковывается в decoded.txt
+   блоками, одним рабочим потоком и по числу ядер */
+int RunPipeline(const std::string& text)
 {
-public:
-    class Node;                                                                                         // Класс "Узел"
+    bool success = true;
 
-    HuffmanTree();                                                                                      // Конструктор
+    for (unsigned workerCount : { 1u, 0u })
+    {
+        BlockPipeline pipeline(1 << 20, workerCount);
+        auto start = std::chrono::steady_clock::now();
 
-    ~HuffmanTree();                                                                                     // Деструктор
+        std::ifstream inputFile("input.txt", std::ios::binary);
+        std::ofstream encodedFile("encoded.bin", std::ios::binary);
+        success &= pipeline.Compress(inputFile, encodedFile);
+        encodedFile.close();
 
-    void BuildHuffmanTree(const std::string& text);                                                     // Построение дерева Хаффмана
+        std::chrono::duration<double> compressTime = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
 
-    std::string Encode(char symbol) const;                                                              // Кодирование отдельного символа
+        std::ifstream encodedInputFile("encoded.bin", std::ios::binary);
+        std::ofstream decodedFile("decoded.txt", std::ios::binary);
+        success &= pipeline.Decompress(encodedInputFile, decodedFile);
+        decodedFile.close();
 
-    std::pair<std::string, double> Encode(const std::string& text) const;                               // Кодирование текста
+        std::chrono::duration<double> decompressTime = std::chrono::steady_clock::now() - start;
 
-    std::string Decode(const std::string& text) const;                                                  // Декодирование текста
+        std::cout << "Рабочих потоков: " << (workerCount ? "1" : "по числу ядер") << ", сжатие: " << compressTime.count() << " с, распаковка: " << decompressTime.count() << " с" << std::endl;
+    }
 
-private:
-    Node* m_root = nullptr;
+    std::ifstream encodedInputFile("encoded.bin", std::ios::binary | std::ios::ate);
+    std::ifstream decodedInputFile("decoded.txt", std::ios::binary);
+    std::string decodedText((std::istreambuf_iterator<char>(decodedInputFile)), std::istreambuf_iterator<char>());
 
-    void DestructorAuxiliary(Node* node);                                                               // Удаление дерева
+    if (!text.empty())
+    {
+        std::cout << "Коэффициент сжатия: " << static_cast<double>(text.size()) / static_cast<double>(encodedInputFile.tellg()) << std::endl;
+    }
 
-    void CalculateFrequencies(Node* node, std::unordered_map<char, int>& frequencyMap) const;           // Подсчёт частот символов
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
 
-    void EncodeAuxiliary(Node* node, char symbol, std::string currentCode, std::string& encodedSymbol) const;
-};
+    return 0;
+}
 
-/* Класс "Узел" */
-class HuffmanTree::Node
+/* Поток одной таблицей: input.txt читается дважды отрезками, так что
+   размер файла ограничен только диском. Первый проход - точная
+   гистограмма или выборка 1/16 входа */
+int RunStream(const std::string& text)
 {
-public:
-    char m_char;
-    int m_frequency;
-    Node* m_left;
-    Node* m_right;
+    HuffmanStreamCoder sampledCoder(1 << 20, 1 << 16);
+    uint64_t sampledSize = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::ifstream inputFile("input.txt", std::ios::binary);
+        std::stringstream encoded;
+        sampledCoder.Compress(inputFile, encoded);
+        sampledSize = encoded.str().size();
+    }
 
-    Node(char huffmanChar, int frequency, Node* m_left = nullptr, Node* m_right = nullptr)
-        : m_char(huffmanChar), m_frequency(frequency), m_left(m_left), m_right(m_right) {}
+    std::chrono::duration<double> sampledTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Выборка: сжатие " << sampledTime.count() << " с, " << sampledSize << " байт" << std::endl;
 
-};
+    HuffmanStreamCoder coder;
+    start = std::chrono::steady_clock::now();
 
-/* Конструктор */
-HuffmanTree::HuffmanTree()
-{
-    m_root = nullptr;
+    std::ifstream inputFile("input.txt", std::ios::binary);
+    std::ofstream encodedFile("encoded.bin", std::ios::binary);
+    bool success = coder.Compress(inputFile, encodedFile);
+    encodedFile.close();
+
+    std::chrono::duration<double> compressTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    std::ifstream encodedInputFile("encoded.bin", std::ios::binary);
+    std::ofstream decodedFile("decoded.txt", std::ios::binary);
+    success &= coder.Decompress(encodedInputFile, decodedFile);
+    decodedFile.close();
+
+    std::chrono::duration<double> decompressTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Сжатие: " << compressTime.count() << " с, распаковка: " << decompressTime.count() << " с" << std::endl;
+
+    std::ifstream encodedSizeFile("encoded.bin", std::ios::binary | std::ios::ate);
+    std::ifstream decodedInputFile("decoded.txt", std::ios::binary);
+    std::string decodedText((std::istreambuf_iterator<char>(decodedInputFile)), std::istreambuf_iterator<char>());
+
+    if (!text.empty())
+    {
+        std::cout << "Коэффициент сжатия: " << static_cast<double>(text.size()) / static_cast<double>(encodedSizeFile.tellg()) << std::endl;
+    }
+
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
+
+    return 0;
 }
 
-/* Деструктор */
-HuffmanTree::~HuffmanTree()
+/* Название типа блока по его первому байту */
+const char* BlockTypeName(uint8_t typeByte)
 {
-    DestructorAuxiliary(m_root);
+    switch (typeByte & ~HuffmanBlock::ChecksumFlag)
+    {
+    case HuffmanBlock::Stored:
+        return "хранимый";
+    case HuffmanBlock::Huffman:
+        return "байтовый";
+    case HuffmanBlock::Utf8:
+        return "кодовые точки";
+    case HuffmanBlock::Interleaved:
+        return "чередующиеся потоки";
+    case HuffmanBlock::Tans:
+        return "tANS";
+    case HuffmanBlock::Lz:
+        return "LZ77";
+    default:
+        return "неизвестный";
+    }
 }
 
-void HuffmanTree::DestructorAuxiliary(Node* node)
+/* Вывод показателей сжатия. Для хранимого блока гистограмма не строится,
+   поэтому вместо границы Шеннона и избыточности печатается тип блока */
+void PrintMetrics(const std::vector<uint8_t>& block, const CompressionMetrics& metrics)
 {
-    if (node)
+    std::cout << "Коэффициент сжатия: " << metrics.CompressionRatio() << std::endl;
+    std::cout << "Данные: " << metrics.m_payloadBits << " бит, заголовок: " << metrics.m_headerBytes << " байт, блок: " << metrics.m_containerBytes << " байт" << std::endl;
+
+    if (!block.empty() && (block[0] & ~HuffmanBlock::ChecksumFlag) == HuffmanBlock::Stored)
     {
-        DestructorAuxiliary(node->m_left);
-        DestructorAuxiliary(node->m_right);
+        std::cout << "Хранимый блок: данные без сжатия" << std::endl;
 
-        delete node;
+        return;
     }
+
+    std::cout << "Граница Шеннона: " << metrics.m_entropyBits << " бит, избыточность: " << metrics.m_redundancy << " бит/символ" << std::endl;
 }
 
-/* Построение дерева Хаффмана */
-void HuffmanTree::BuildHuffmanTree(const std::string& text)
+/* Алфавит кодовых точек: сравнение с байтовым блоком */
+int RunUtf8(const std::string& text)
 {
-    std::unordered_map<char, int> frequencyMap;
+    auto result = HuffmanBlock::EncodeUtf8(text);
+    PrintMetrics(result.first, result.second);
+    std::cout << "Тип блока: " << BlockTypeName(result.first[0]) << ", байтовый блок: " << HuffmanBlock::Encode(text).second.m_containerBytes << " байт" << std::endl;
 
-    for (char huffmanChar : text)
-    {
-        if (frequencyMap.count(huffmanChar) == 0)
-        {
-            frequencyMap[huffmanChar] = 1;
-        }
-        else
-        {
-            frequencyMap[huffmanChar]++;
-        }
-    }
+    std::string decodedText;
+    bool success = HuffmanBlock::Decode(result.first, decodedText);
 
-    std::list<Node*> nodeList;
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
 
-    for (auto& element : frequencyMap)
-    {
-        nodeList.push_back(new Node(element.first, element.second));
-    }
+    return 0;
+}
 
-    /* Сортируем по возрастанию частоты символов в узлах */
-    while (nodeList.size() != 1)
+/* LZ77 с кодами Хаффмана: блок уровня по умолчанию и размеры на других уровнях */
+int RunLz(const std::string& text)
+{
+    auto result = HuffmanBlock::EncodeLz(text, Lz77Coder::DefaultWindowBits, Lz77Coder::DefaultLevel);
+    PrintMetrics(result.first, result.second);
+    std::cout << "Тип блока: " << BlockTypeName(result.first[0]) << ", байтовый блок: " << HuffmanBlock::Encode(text).second.m_containerBytes << " байт" << std::endl;
+
+    for (int level = Lz77Coder::MinLevel; level <= Lz77Coder::MaxLevel; level += 4)
     {
-        nodeList.sort([](Node* left, Node* right)
-            {
-                return left->m_frequency < right->m_frequency;
-            });
+        std::cout << "Уровень " << level << ": " << HuffmanBlock::EncodeLz(text, Lz77Coder::DefaultWindowBits, level).second.m_containerBytes << " байт" << std::endl;
+    }
 
-        /* Извлекаем два узла с наименьшей частотой из начала списка */
-        Node* node1 = nodeList.front();
-        nodeList.pop_front();
-        Node* node2 = nodeList.front();
-        nodeList.pop_front();
+    std::string decodedText;
+    bool success = HuffmanBlock::Decode(result.first, decodedText);
 
-        Node* newNode = new Node('\0', node1->m_frequency + node2->m_frequency, node1, node2);
-        nodeList.push_back(newNode);
-    }
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
 
-    m_root = nodeList.front();
-    nodeList.pop_front();
+    return 0;
 }
 
-/* Кодирование отдельного символа, текста */
-std::string HuffmanTree::Encode(char symbol) const
+/* Адаптивный режим: один проход, без заголовка */
+int RunAdaptive(const std::string& text)
 {
-    std::string encodedSymbol = "";
-    EncodeAuxiliary(m_root, symbol, "", encodedSymbol);
+    AdaptiveHuffmanTree encoder;
+    std::string encodedText = encoder.Encode(text);
+    std::cout << "Коэффициент сжатия (адаптивный): " << (static_cast<double>(text.size()) * 8) / encodedText.size() << std::endl;
+
+    AdaptiveHuffmanTree decoder;
+    std::string decodedText;
+    bool success = decoder.Decode(encodedText, decodedText) == HuffmanTree::DecodeSuccess;
+
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
 
-    return encodedSymbol;
+    return 0;
 }
 
-std::pair<std::string, double> HuffmanTree::Encode(const std::string& text) const
+/* Полуадаптивный режим: периодическая перестройка таблицы */
+int RunSemiAdaptive(const std::string& text)
 {
-    std::string encodedText = "";
+    SemiAdaptiveHuffmanCoder encoder;
+    std::vector<uint8_t> encodedText = encoder.Encode(text);
+    std::cout << "Коэффициент сжатия (полуадаптивный): " << static_cast<double>(text.size()) / encodedText.size() << std::endl;
 
-    for (char huffmanChar : text)
-    {
-        encodedText += Encode(huffmanChar);
-    }
+    SemiAdaptiveHuffmanCoder decoder;
+    std::string decodedText;
+    bool success = decoder.Decode(encodedText, text.size(), decodedText) == HuffmanTree::DecodeSuccess;
 
-    double compressioRatio = (static_cast<double>(text.size()) * 8) / encodedText.size();
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
 
-    return std::make_pair(encodedText, compressioRatio);
+    return 0;
 }
 
-void HuffmanTree::EncodeAuxiliary(Node* node, char symbol, std::string currentCode, std::string& encodedSymbol) const
+/* Частоты статического кодека: буквы английского текста, остальные байты
+   с частотой 1, чтобы кодировался любой вход */
+constexpr std::array<int, 256> MakeTextFrequencies()
 {
-    if (!node)
+    const char letters[] = " etaoinshrdlcumwfgypbvkjxqz";
+    const int counts[] = { 1800, 1270, 906, 817, 751, 697, 675, 633, 609, 599, 425, 403, 278, 276, 241, 236, 223, 202, 197, 193, 149, 98, 77, 15, 15, 10, 7 };
+    std::array<int, 256> frequencies{};
+
+    for (int& frequency : frequencies)
     {
-        return;
+        frequency = 1;
     }
 
-    if (node->m_char == symbol)
+    for (int letter = 0; letter < static_cast<int>(sizeof(counts) / sizeof(counts[0])); letter++)
     {
-        encodedSymbol = currentCode;
+        unsigned char symbol = static_cast<unsigned char>(letters[letter]);
+        frequencies[symbol] = counts[letter];
 
-        return;
+        if (symbol >= 'a' && symbol <= 'z')
+        {
+            frequencies[symbol - 'a' + 'A'] = counts[letter] / 10 + 1;
+        }
     }
 
-    EncodeAuxiliary(node->m_left, symbol, currentCode + "0", encodedSymbol);
-    EncodeAuxiliary(node->m_right, symbol, currentCode + "1", encodedSymbol);
+    frequencies['\n'] = 200;
+    frequencies['.'] = 100;
+    frequencies[','] = 100;
+
+    return frequencies;
 }
 
-/* Декодирование текста */
-std::string HuffmanTree::Decode(const std::string& text) const
+constexpr std::array<int, 256> textFrequencies = MakeTextFrequencies();
+constexpr StaticHuffmanTables textTables = BuildStaticHuffmanTables(textFrequencies);
+using TextCodec = StaticHuffmanCodec<textTables>;
+
+/* Статический режим: таблицы построены при компиляции */
+int RunStatic(const std::string& text)
 {
-    std::string decodedText = "";
-    Node* currentNode = m_root;
+    std::vector<uint8_t> encodedText;
 
-    for (char huffmanChar : text)
+    if (!TextCodec::Encode(text, encodedText))
     {
-        if (huffmanChar == '0')
-        {
-            currentNode = currentNode->m_left;
-        }
-        else
-        {
-            currentNode = currentNode->m_right;
-        }
+        std::cout << "В тексте есть символы без кода в статических таблицах" << std::endl;
 
-        if (!currentNode->m_left && !currentNode->m_right)
-        {
-            decodedText += currentNode->m_char;
-            currentNode = m_root;
-        }
+        return 1;
+    }
+
+    std::cout << "Коэффициент сжатия (статический): " << (static_cast<double>(text.size())) / encodedText.size() << std::endl;
+
+    /* Коды должны совпадать с деревом, построенным во время выполнения */
+    HuffmanTree runtimeTree;
+    runtimeTree.BuildHuffmanTree(std::vector<uint64_t>(textFrequencies.begin(), textFrequencies.end()));
+    std::vector<HuffmanTree::Code> runtimeCodes = runtimeTree.BuildPackedCodeTable();
+    bool sameCodes = true;
+
+    for (int symbol = 0; symbol < StaticHuffmanTables::AlphabetSize; symbol++)
+    {
+        sameCodes &= runtimeCodes[symbol].m_bits == textTables.m_codes[symbol] && runtimeCodes[symbol].m_length == textTables.m_lengths[symbol];
     }
 
-    return decodedText;
+    std::cout << "Коды " << (sameCodes ? "совпадают" : "не совпадают") << " с деревом HuffmanTree" << std::endl;
+
+    std::string decodedText;
+    bool success = TextCodec::Decode(encodedText, text.size(), decodedText) == HuffmanTree::DecodeSuccess;
+    std::cout << "Декодирование прошло " << ((success && text == decodedText) ? "успешно" : "неудачно") << std::endl;
+
+    return 0;
+}
+
+/* Замер скорости декодирования, МБ/с */
+double MeasureThroughput(size_t bytes, const std::function<void()>& action)
+{
+    auto start = std::chrono::steady_clock::now();
+    action();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return bytes / elapsed.count() / (1024 * 1024);
 }
 
-/* Подчсёт частот символов */
-void HuffmanTree::CalculateFrequencies(Node* node, std::unordered_map<char, int>& frequencyMap) const
+/* Сравнение декодеров на тексте, повторённом до 32 МБ */
+int RunBenchmark(const std::string& text)
 {
-    if (!node)
+    std::string benchmarkText = text;
+
+    while (!benchmarkText.empty() && benchmarkText.size() < 32 * 1024 * 1024)
     {
-        return;
+        benchmarkText += benchmarkText;
     }
 
-    if (!node->m_left && !node->m_right)
+    HuffmanTree benchmarkTree;
+    benchmarkTree.BuildHuffmanTree(benchmarkText);
+    std::vector<uint8_t> encodedText = benchmarkTree.EncodePacked(benchmarkText).first;
+    HuffmanDecodeTable decodeTable(benchmarkTree);
+    size_t size = benchmarkText.size();
+    bool success = true;
+
+    std::cout << "Обход дерева: " << MeasureThroughput(size, [&]() { success &= benchmarkTree.DecodePacked(encodedText, size) == benchmarkText; }) << " МБ/с" << std::endl;
+    std::cout << "Таблица, 1 символ: " << MeasureThroughput(size, [&]() { success &= decodeTable.DecodeSingle(encodedText, size) == benchmarkText; }) << " МБ/с" << std::endl;
+    std::cout << "Таблица, до 4 символов: " << MeasureThroughput(size, [&]() { success &= decodeTable.Decode(encodedText, size) == benchmarkText; }) << " МБ/с" << std::endl;
+
+    HuffmanStateMachine stateMachine(benchmarkTree);
+    std::cout << "Автомат по байтам (" << stateMachine.StateCount() << " состояний): " << MeasureThroughput(size, [&]() { success &= stateMachine.Decode(encodedText, size) == benchmarkText; }) << " МБ/с" << std::endl;
+
+    /* Полуадаптивный режим: таблица перестраивается каждые 4 КБ */
+    SemiAdaptiveHuffmanCoder semiAdaptiveCoder;
+    std::vector<uint8_t> semiAdaptiveText;
+    std::string semiAdaptiveDecoded;
+    std::cout << "Полуадаптивный: кодирование " << MeasureThroughput(size, [&]() { semiAdaptiveText = semiAdaptiveCoder.Encode(benchmarkText); }) << " МБ/с";
+    std::cout << ", декодирование " << MeasureThroughput(size, [&]() { success &= semiAdaptiveCoder.Decode(semiAdaptiveText, size, semiAdaptiveDecoded) == HuffmanTree::DecodeSuccess && semiAdaptiveDecoded == benchmarkText; }) << " МБ/с" << std::endl;
+
+    /* Гистограмма и ядра для каждого доступного уровня, у которого они свои
+       (уровень Sse42 влияет только на CRC32C) */
+    std::vector<HuffmanTree::Code> codeTable = benchmarkTree.BuildPackedCodeTable();
+    std::vector<uint64_t> kernelFrequencies(256);
+    std::string kernelText;
+
+    std::cout << "Гистограмма: " << MeasureThroughput(size, [&]() { HuffmanKernels::CountBytes(benchmarkText.data(), size, kernelFrequencies.data()); }) << " МБ/с" << std::endl;
+
+    for (CpuFeatures::Isa level : { CpuFeatures::Scalar, CpuFeatures::Avx2, CpuFeatures::Bmi2 })
     {
-        if (frequencyMap.count(node->m_char) == 0)
+        if (!CpuFeatures::Supports(level))
         {
-            frequencyMap[node->m_char] = 1;
+            continue;
         }
-        else
+
+        std::cout << "Ядра " << CpuFeatures::Name(level) << ": кодирование " << MeasureThroughput(size, [&]() { BitWriter writer(encodedText.size()); HuffmanKernels::EncodeBytes(level, benchmarkText.data(), size, codeTable.data(), codeTable.size(), writer); success &= writer.Finish() == encodedText; }) << " МБ/с";
+        std::cout << ", декодирование " << MeasureThroughput(size, [&]() { success &= decodeTable.Decode(level, encodedText.data(), encodedText.size(), size, kernelText) == HuffmanTree::DecodeSuccess && kernelText == benchmarkText; }) << " МБ/с" << std::endl;
+    }
+
+    /* Чередующиеся потоки: декодирование по очереди и всех потоков сразу */
+    for (int laneCount : { 8, 16 })
+    {
+        std::vector<uint8_t> lanes;
+        std::vector<size_t> laneSizes;
+
+        for (int lane = 0; lane < laneCount; lane++)
         {
-            frequencyMap[node->m_char]++;
+            std::string laneText;
+
+            for (size_t position = lane; position < size; position += laneCount)
+            {
+                laneText.push_back(benchmarkText[position]);
+            }
+
+            BitWriter writer(laneText.size());
+            HuffmanKernels::EncodeBytes(laneText.data(), laneText.size(), codeTable.data(), codeTable.size(), writer);
+            std::vector<uint8_t> lanePayload = writer.Finish();
+            lanes.insert(lanes.end(), lanePayload.begin(), lanePayload.end());
+            laneSizes.push_back(lanePayload.size());
         }
+
+        std::cout << "Потоков " << laneCount << ": по очереди " << MeasureThroughput(size, [&]() { success &= decodeTable.DecodeInterleaved(CpuFeatures::Scalar, lanes.data(), laneSizes, size, kernelText) == HuffmanTree::DecodeSuccess && kernelText == benchmarkText; }) << " МБ/с";
+        std::cout << ", " << CpuFeatures::Name(CpuFeatures::Best()) << " " << MeasureThroughput(size, [&]() { success &= decodeTable.DecodeInterleaved(lanes.data(), laneSizes, size, kernelText) == HuffmanTree::DecodeSuccess && kernelText == benchmarkText; }) << " МБ/с" << std::endl;
+    }
+
+    /* Перестроение дерева: один объект с пулом узлов против нового объекта */
+    const int rebuildCount = 10000;
+    HuffmanTree pooledTree;
+
+    std::cout << "Перестроение дерева, один объект: " << MeasureThroughput(rebuildCount, [&]() { for (int rebuild = 0; rebuild < rebuildCount; rebuild++) pooledTree.BuildHuffmanTree(text); }) * 1024 * 1024 << " раз/с" << std::endl;
+    std::cout << "Перестроение дерева, новый объект: " << MeasureThroughput(rebuildCount, [&]() { for (int rebuild = 0; rebuild < rebuildCount; rebuild++) HuffmanTree().BuildHuffmanTree(text); }) * 1024 * 1024 << " раз/с" << std::endl;
+
+    /* Большой алфавит с вырожденным деревом: частоты первых символов - числа
+       Фибоначчи (цепочка), остальные встречаются по разу */
+    std::vector<uint64_t> deepFrequencies(65536, 1);
+
+    for (size_t symbol = 2; symbol < 60; symbol++)
+    {
+        deepFrequencies[symbol] = deepFrequencies[symbol - 1] + deepFrequencies[symbol - 2];
+    }
+
+    HuffmanTree deepTree;
+    HuffmanTree restoredTree;
+    std::vector<int> deepLengths;
+    const int deepCount = 10;
+
+    std::cout << "Алфавит 65536, построение: " << MeasureThroughput(deepCount, [&]() { for (int rebuild = 0; rebuild < deepCount; rebuild++) deepTree.BuildHuffmanTree(deepFrequencies); }) * 1024 * 1024 << " раз/с" << std::endl;
+    std::cout << "Алфавит 65536, длины кодов: " << MeasureThroughput(deepCount, [&]() { for (int rebuild = 0; rebuild < deepCount; rebuild++) deepLengths = deepTree.BuildCodeLengths(); }) * 1024 * 1024 << " раз/с" << std::endl;
+    std::cout << "Алфавит 65536, дерево-массив: " << MeasureThroughput(deepCount, [&]() { for (int rebuild = 0; rebuild < deepCount; rebuild++) deepTree.BuildFlatTree(); }) * 1024 * 1024 << " раз/с" << std::endl;
+
+    HuffmanTree::Statistics deepStatistics = deepTree.CalculateStatistics();
+    success &= HuffmanTree::CheckKraft(deepLengths, true) && deepStatistics.m_weights == deepFrequencies;
+    success &= restoredTree.BuildFromCodeLengths(deepLengths) && restoredTree.BuildCodeLengths() == deepLengths;
+    std::cout << "Алфавит 65536, глубина дерева: " << deepStatistics.m_depthHistogram.size() - 1 << std::endl;
+
+    /* Контрольная сумма: CRC32C отдельно и декодирование блока с ней и без неё */
+    uint32_t hardwareCrc = 0;
+    uint32_t slicedCrc = 0;
+
+    if (Crc32c::HasHardwareSupport())
+    {
+        std::cout << "CRC32C, SSE4.2: " << MeasureThroughput(size, [&]() { hardwareCrc = Crc32c::CalculateHardware(benchmarkText.data(), size); }) << " МБ/с" << std::endl;
     }
 
-    CalculateFrequencies(node->m_left, frequencyMap);
-    CalculateFrequencies(node->m_right, frequencyMap);
+    std::cout << "CRC32C, таблицы: " << MeasureThroughput(size, [&]() { slicedCrc = Crc32c::CalculateSliced(benchmarkText.data(), size); }) << " МБ/с" << std::endl;
+    success &= !Crc32c::HasHardwareSupport() || hardwareCrc == slicedCrc;
+
+    std::vector<uint8_t> plainBlock = HuffmanBlock::Encode(benchmarkText).first;
+    std::vector<uint8_t> checkedBlock = HuffmanBlock::Encode(benchmarkText, CompressibilityEstimator(), true).first;
+    std::string blockText;
+
+    std::cout << "Блок без контрольной суммы: " << MeasureThroughput(size, [&]() { success &= HuffmanBlock::Decode(plainBlock, blockText); }) << " МБ/с" << std::endl;
+    std::cout << "Блок с контрольной суммой: " << MeasureThroughput(size, [&]() { success &= HuffmanBlock::Decode(checkedBlock, blockText); }) << " МБ/с" << std::endl;
+    success &= blockText == benchmarkText;
+
+    /* tANS на том же тексте; Encode выбирает его сам, только если он заметно меньше */
+    std::vector<uint8_t> tansBlock;
+    std::cout << "Блок tANS: кодирование " << MeasureThroughput(size, [&]() { tansBlock = HuffmanBlock::EncodeTans(benchmarkText).first; }) << " МБ/с";
+    std::cout << ", декодирование " << MeasureThroughput(size, [&]() { success &= HuffmanBlock::Decode(tansBlock, blockText); }) << " МБ/с";
+    std::cout << ", " << tansBlock.size() << " байт против " << plainBlock.size() << (plainBlock[0] == HuffmanBlock::Tans ? " (выбран tANS)" : " (выбран Хаффман)") << std::endl;
+    success &= blockText == benchmarkText;
+
+    /* LZ77: окно меньше периода повторённого текста, поэтому совпадения
+       находятся только внутри исходного текста */
+    std::vector<uint8_t> lzBlock;
+    std::cout << "Блок LZ77: кодирование " << MeasureThroughput(size, [&]() { lzBlock = HuffmanBlock::EncodeLz(benchmarkText, Lz77Coder::DefaultWindowBits, Lz77Coder::DefaultLevel).first; }) << " МБ/с";
+    std::cout << ", декодирование " << MeasureThroughput(size, [&]() { success &= HuffmanBlock::Decode(lzBlock, blockText); }) << " МБ/с";
+    std::cout << ", " << lzBlock.size() << " байт против " << plainBlock.size() << std::endl;
+    success &= blockText == benchmarkText;
+
+    /* Несжимаемые данные: оценка по выборке против полного кодирования */
+    std::string randomText(size, '\0');
+    uint32_t state = 1;
+
+    for (char& huffmanChar : randomText)
+    {
+        state = state * 1664525 + 1013904223;
+        huffmanChar = static_cast<char>(state >> 24);
+    }
+
+    std::cout << "Несжимаемые данные, с оценкой: " << MeasureThroughput(size, [&]() { success &= HuffmanBlock::Encode(randomText).first[0] == HuffmanBlock::Stored; }) << " МБ/с" << std::endl;
+    std::cout << "Несжимаемые данные, без оценки: " << MeasureThroughput(size, [&]() { HuffmanBlock::Encode(randomText, CompressibilityEstimator(-1.0)); }) << " МБ/с" << std::endl;
+
+    std::cout << "Декодирование прошло " << (success ? "успешно" : "неудачно") << std::endl;
+
+    return 0;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
     setlocale(LC_ALL, "Russian");
 
     std::ifstream inputFile("input.txt");
     std::string text((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
 
-    HuffmanTree labHuffmanTree;
-    labHuffmanTree.BuildHuffmanTree(text);
+    if (argc > 1 && std::strcmp(argv[1], "adaptive") == 0)
+    {
+        return RunAdaptive(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "semiadaptive") == 0)
+    {
+        return RunSemiAdaptive(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "static") == 0)
+    {
+        return RunStatic(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "shared") == 0)
+    {
+        return RunShared(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "pipeline") == 0)
+    {
+        return RunPipeline(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "stream") == 0)
+    {
+        return RunStream(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "utf8") == 0)
+    {
+        return RunUtf8(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "lz") == 0)
+    {
+        return RunLz(text);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0)
+    {
+        return RunBenchmark(text);
+    }
 
-    auto result = labHuffmanTree.Encode(text);
-    std::string encodedText = result.first;
-    double compressionRatio = result.second;
-    std::cout << "Коэффициент сжатия: " << compressionRatio << std::endl;
+    auto result = HuffmanBlock::Encode(text);
+    std::vector<uint8_t> encodedText = result.first;
+    PrintMetrics(result.first, result.second);
 
-    std::ofstream encodedFile("encoded.txt");
-    encodedFile << encodedText;
+    std::ofstream encodedFile("encoded.bin", std::ios::binary);
+    encodedFile.write(reinterpret_cast<const char*>(encodedText.data()), encodedText.size());
     encodedFile.close();
 
-    std::ifstream encodedInputFile("encoded.txt");
-    std::string encodedInputText((std::istreambuf_iterator<char>(encodedInputFile)), std::istreambuf_iterator<char>());
+    std::ifstream encodedInputFile("encoded.bin", std::ios::binary);
+    std::vector<uint8_t> encodedInputText((std::istreambuf_iterator<char>(encodedInputFile)), std::istreambuf_iterator<char>());
 
-    std::string decodedText = labHuffmanTree.Decode(encodedInputText);
+    std::string decodedText;
+    HuffmanBlock::Decode(encodedInputText, decodedText);
     std::ofstream decodedFile("decoded.txt");
     decodedFile << decodedText;
     decodedFile.close();